@@ -0,0 +1,368 @@
+//
+//  Benchmarks.cpp
+//  KinectV1Depth
+//
+
+#include "Benchmarks.h"
+#include "ofxOpenCv.h"
+#include "IntegralImage.h"
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runMorphology( const DepthMorphology::Settings& asettings, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    const int sizes[][2] = { {320, 240}, {640, 480}, {512, 424} };
+    
+    for( auto& size : sizes ) {
+        int width = size[0];
+        int height = size[1];
+        string sizeName = ofToString(width)+"x"+ofToString(height);
+        
+        // something like a depth image, a few bodies in front of a noisy background //
+        ofPixels depth;
+        depth.allocate( width, height, 1 );
+        ofSeedRandom( 42 );
+        vector< ofVec3f > blobs;
+        for( int i = 0; i < 6; i++ ) {
+            blobs.push_back( ofVec3f( ofRandom(width), ofRandom(height), ofRandom(0.05, 0.2) * height ) );
+        }
+        for( int y = 0; y < height; y++ ) {
+            for( int x = 0; x < width; x++ ) {
+                float value = ofRandom( 0, 70 );
+                for( auto& blob : blobs ) {
+                    float dist = ofDist( x, y, blob.x, blob.y );
+                    if( dist < blob.z ) value = std::max( value, 255.f - 150.f * dist / blob.z + ofRandom(-20, 20) );
+                }
+                depth[ y * width + x ] = (unsigned char)ofClamp( value, 0, 255 );
+            }
+        }
+        
+        ofxCvGrayscaleImage sourceCv;
+        sourceCv.setUseTexture( false );
+        sourceCv.allocate( width, height );
+        sourceCv.setFromPixels( depth );
+        ofxCvGrayscaleImage chainCv;
+        chainCv.setUseTexture( false );
+        chainCv.allocate( width, height );
+        ofxCvGrayscaleImage fusedCv;
+        fusedCv.setUseTexture( false );
+        fusedCv.allocate( width, height );
+        
+        // as DepthProcessor did it before DepthMorphology //
+        BenchmarkResult chainResult;
+        chainResult.name = "morphology "+sizeName+", ofxOpenCv";
+        uint64_t startMicros = ofGetElapsedTimeMicros();
+        for( int pass = 0; pass < anumPasses; pass++ ) {
+            chainCv = sourceCv;
+            chainCv.threshold( asettings.threshold );
+            for( int i = 0; i < asettings.numPasses; i++ ) {
+                chainCv.dilate();
+                if( asettings.blurSize > 1 ) chainCv.blurGaussian( asettings.blurSize );
+                chainCv.erode_3x3();
+            }
+        }
+        chainResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+        chainResult.count = anumPasses;
+        results.push_back( chainResult );
+        
+        BenchmarkResult fusedResult;
+        fusedResult.name = "morphology "+sizeName+", fused";
+        DepthMorphology morphology;
+        IplImage* src = sourceCv.getCvImage();
+        IplImage* dst = fusedCv.getCvImage();
+        startMicros = ofGetElapsedTimeMicros();
+        for( int pass = 0; pass < anumPasses; pass++ ) {
+            morphology.process( (const uint8_t*)src->imageData, src->widthStep, (uint8_t*)dst->imageData, dst->widthStep, width, height, asettings );
+        }
+        fusedResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+        fusedResult.count = anumPasses;
+        fusedCv.flagImageChanged();
+        results.push_back( fusedResult );
+        
+        const ofPixels& expected = chainCv.getPixels();
+        const ofPixels& actual = fusedCv.getPixels();
+        size_t numDifferent = 0;
+        for( size_t i = 0; i < (size_t)width * height; i++ ) {
+            if( expected[i] != actual[i] ) numDifferent++;
+        }
+        if( numDifferent ) {
+            ofLogError("Benchmarks") << "morphology " << sizeName << ": " << numDifferent << " pixels differ from the ofxOpenCv chain";
+        }
+    }
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runHitBoxes( int anumCols, int anumRows, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    if( anumCols <= 0 || anumRows <= 0 ) return results;
+    const int width = 320;
+    const int height = 240;
+    const float screenWidth = 1024;
+    const float screenHeight = 768;
+    string gridName = ofToString(anumCols)+"x"+ofToString(anumRows);
+    
+    // a motion mask with a few moving edges and some noise //
+    ofPixels mask;
+    mask.allocate( width, height, 1 );
+    ofSeedRandom( 42 );
+    for( int y = 0; y < height; y++ ) {
+        for( int x = 0; x < width; x++ ) {
+            bool bEdge = ((x + y/3) % 40) < 3 || ofRandom(1) < 0.02;
+            mask[ y * width + x ] = bEdge ? (unsigned char)ofRandom( 1, 255 ) : 0;
+        }
+    }
+    ofxCvGrayscaleImage maskCv;
+    maskCv.setUseTexture( false );
+    maskCv.allocate( width, height );
+    maskCv.setFromPixels( mask );
+    
+    vector< ofRectangle > boxes;
+    for( int x = 0; x < anumCols; x++ ) {
+        for( int y = 0; y < anumRows; y++ ) {
+            ofRectangle rect;
+            rect.width = screenWidth / anumCols;
+            rect.height = screenHeight / anumRows;
+            rect.x = rect.width * (float)x;
+            rect.y = rect.height * (float)y;
+            boxes.push_back( rect );
+        }
+    }
+    
+    // as DepthProcessor did it before the IntegralImage //
+    BenchmarkResult regionResult;
+    regionResult.name = "hit boxes "+gridName+", countNonZeroInRegion";
+    vector< int > expected( boxes.size() );
+    float rxscale = width / screenWidth;
+    float ryscale = height / screenHeight;
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        for( size_t i = 0; i < boxes.size(); i++ ) {
+            ofRectangle tempRect = boxes[i];
+            tempRect.x *= rxscale;
+            tempRect.width *= rxscale;
+            tempRect.y *= ryscale;
+            tempRect.height *= ryscale;
+            expected[i] = maskCv.countNonZeroInRegion( tempRect.x, tempRect.y, tempRect.width, tempRect.height );
+        }
+    }
+    regionResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    regionResult.count = anumPasses;
+    results.push_back( regionResult );
+    
+    BenchmarkResult integralResult;
+    integralResult.name = "hit boxes "+gridName+", integral image";
+    vector< IntegralImage::Region > regions( boxes.size() );
+    for( size_t i = 0; i < boxes.size(); i++ ) {
+        regions[i].x        = boxes[i].x * rxscale;
+        regions[i].y        = boxes[i].y * ryscale;
+        regions[i].width    = boxes[i].width * rxscale;
+        regions[i].height   = boxes[i].height * ryscale;
+    }
+    IntegralImage integral;
+    vector< int > actual( boxes.size() );
+    IplImage* src = maskCv.getCvImage();
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        integral.build( (const uint8_t*)src->imageData, src->widthStep, width, height );
+        for( size_t i = 0; i < regions.size(); i++ ) {
+            actual[i] = integral.getCount( regions[i] );
+        }
+    }
+    integralResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    integralResult.count = anumPasses;
+    results.push_back( integralResult );
+    
+    size_t numDifferent = 0;
+    for( size_t i = 0; i < boxes.size(); i++ ) {
+        if( expected[i] != actual[i] ) numDifferent++;
+    }
+    if( numDifferent ) {
+        ofLogError("Benchmarks") << "hit boxes " << gridName << ": " << numDifferent << " boxes differ from countNonZeroInRegion";
+    }
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runZones( int anumZones, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    if( anumZones <= 0 ) return results;
+    const int width = 320;
+    const int height = 240;
+    string zonesName = ofToString(anumZones)+" zones";
+    
+    // uneven stars, sized so the zones cover the image a few times over //
+    ofSeedRandom( 42 );
+    vector< Zone > zones;
+    float radius = 0.5f / sqrtf( (float)anumZones );
+    for( int i = 0; i < anumZones; i++ ) {
+        Zone tzone;
+        tzone.name = "zone "+ofToString(i);
+        ofVec3f center( ofRandom(1), ofRandom(1) );
+        int numPoints = (int)ofRandom( 3, 12 );
+        for( int j = 0; j < numPoints; j++ ) {
+            float angle = TWO_PI * j / numPoints;
+            float r = radius * ofRandom( 0.3, 2.0 );
+            tzone.polygon.addVertex( center.x + cosf(angle) * r, center.y + sinf(angle) * r );
+        }
+        tzone.polygon.close();
+        zones.push_back( tzone );
+    }
+    
+    vector< uint8_t > motion( width * height );
+    vector< uint8_t > present( width * height );
+    for( size_t i = 0; i < motion.size(); i++ ) {
+        motion[i] = ofRandom(1) < 0.1 ? 255 : 0;
+        present[i] = ofRandom(1) < 0.4 ? 255 : 0;
+    }
+    
+    BenchmarkResult rasterResult;
+    rasterResult.name = zonesName+", rasterize";
+    ZoneMap zoneMap;
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    int numRasterPasses = std::max( anumPasses / 10, 1 );
+    for( int pass = 0; pass < numRasterPasses; pass++ ) {
+        zoneMap.setZones( zones );
+        zoneMap.update( width, height );
+    }
+    rasterResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    rasterResult.count = numRasterPasses;
+    results.push_back( rasterResult );
+    
+    BenchmarkResult countResult;
+    countResult.name = zonesName+", count";
+    vector< ZoneState > states;
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        zoneMap.update( width, height );
+        zoneMap.count( &motion[0], width, &present[0], width, NULL, 0, states );
+    }
+    countResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    countResult.count = anumPasses;
+    results.push_back( countResult );
+    
+    // the topmost zone at each pixel centre, and the counts from it //
+    vector< ofPolyline > polygons;
+    for( auto& zone : zones ) {
+        ofPolyline tpoly = zone.polygon;
+        for( auto& vert : tpoly.getVertices() ) {
+            vert.x *= width;
+            vert.y *= height;
+        }
+        polygons.push_back( tpoly );
+    }
+    vector< ZoneState > expected( zones.size() );
+    size_t numDifferent = 0;
+    const vector< uint16_t >& labels = zoneMap.getLabels();
+    for( int y = 0; y < height; y++ ) {
+        for( int x = 0; x < width; x++ ) {
+            int label = 0;
+            for( int z = (int)polygons.size()-1; z >= 0; z-- ) {
+                if( ofPolyline::inside( x + 0.5f, y + 0.5f, polygons[z] ) ) {
+                    label = z + 1;
+                    break;
+                }
+            }
+            size_t i = y * width + x;
+            if( labels[i] != label ) numDifferent++;
+            if( label ) {
+                expected[label-1].numPixels++;
+                expected[label-1].numMotion += motion[i] != 0;
+                expected[label-1].numPresent += present[i] != 0;
+            }
+        }
+    }
+    for( size_t i = 0; i < states.size(); i++ ) {
+        if( states[i].numPixels != expected[i].numPixels || states[i].numMotion != expected[i].numMotion || states[i].numPresent != expected[i].numPresent ) {
+            numDifferent++;
+        }
+    }
+    if( numDifferent ) {
+        ofLogError("Benchmarks") << zonesName << ": " << numDifferent << " pixels or zones differ from ofPolyline::inside()";
+    }
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runDepthIngest( int anearMm, int afarMm, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    const int width = 640;
+    const int height = 480;
+    
+    // a wall with a few people in front of it and some missing readings //
+    ofSeedRandom( 42 );
+    vector< ofVec3f > blobs;
+    for( int i = 0; i < 4; i++ ) {
+        blobs.push_back( ofVec3f( ofRandom(width), ofRandom(height), ofRandom(40, 120) ) );
+    }
+    ofShortPixels raw;
+    raw.allocate( width, height, 1 );
+    for( int y = 0; y < height; y++ ) {
+        for( int x = 0; x < width; x++ ) {
+            float depth = 4500 + ofRandom( -30, 30 );
+            for( auto& blob : blobs ) {
+                if( ofDist( x, y, blob.x, blob.y ) < blob.z ) depth = 1500 + blob.z * 5 + ofRandom( -30, 30 );
+            }
+            raw.getData()[ y * width + x ] = ofRandom(1) < 0.05 ? 0 : (uint16_t)depth;
+        }
+    }
+    // the 8 bit depth ofxKinect makes in its update() //
+    DepthIngest ingest;
+    ingest.setClipping( anearMm, afarMm );
+    ofPixels kinectDepth;
+    kinectDepth.allocate( width, height, 1 );
+    for( int i = 0; i < width * height; i++ ) {
+        int mm = std::min( (int)raw.getData()[i], (int)DepthIngest::MAX_DEPTH_MM );
+        kinectDepth[i] = mm ? (unsigned char)ofMap( mm, anearMm, afarMm, 255, 0, true ) : 0;
+    }
+    
+    // as ofApp and DepthProcessor did it before the DepthIngest //
+    BenchmarkResult copyResult;
+    copyResult.name = "depth ingest, 8 bit copies";
+    ofPixels inputPixels;
+    ofxCvGrayscaleImage grayCv;
+    grayCv.setUseTexture( false );
+    grayCv.allocate( width, height );
+    ofxCvGrayscaleImage scaledCv;
+    scaledCv.setUseTexture( false );
+    scaledCv.allocate( width/2, height/2 );
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        inputPixels = kinectDepth;
+        grayCv.setFromPixels( inputPixels );
+        grayCv.mirror( true, true );
+        scaledCv.scaleIntoMe( grayCv, CV_INTER_LINEAR );
+    }
+    copyResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    copyResult.count = anumPasses;
+    results.push_back( copyResult );
+    
+    BenchmarkResult ingestResult;
+    ingestResult.name = "depth ingest, raw";
+    ofPixels depth;
+    ofShortPixels depthMm;
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        ingest.process( raw.getData(), width, height, true, true, depth, depthMm );
+    }
+    ingestResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    ingestResult.count = anumPasses;
+    results.push_back( ingestResult );
+    
+    const ofPixels& expected = scaledCv.getPixels();
+    size_t numDifferent = 0;
+    for( size_t i = 0; i < depth.size(); i++ ) {
+        if( expected[i] != depth[i] ) numDifferent++;
+    }
+    if( numDifferent ) {
+        ofLogError("Benchmarks") << "depth ingest: " << numDifferent << " pixels differ from the 8 bit path";
+    }
+    return results;
+}
+
+//--------------------------------------------------------------
+void Benchmarks::log( const vector<BenchmarkResult>& aresults ) {
+    for( auto& result : aresults ) {
+        double nsEach = result.count ? result.seconds * 1000000000.0 / result.count : 0;
+        ofLogNotice("Benchmarks") << result.name << ": " << (uint64_t)result.getPerSecond() << " /sec, " << ofToString(nsEach, 1) << "ns each (" << result.count << " in " << result.seconds << "s)";
+    }
+}
@@ -0,0 +1,42 @@
+//
+//  Benchmarks.h
+//  KinectV1Depth
+//
+//  Micro benchmarks for the depth pipeline, results are logged.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "DepthMorphology.h"
+#include "ZoneMap.h"
+#include "DepthIngest.h"
+
+class BenchmarkResult {
+public:
+    string name;
+    uint64_t count = 0;
+    double seconds = 0;
+    
+    double getPerSecond() const { return seconds > 0 ? (double)count / seconds : 0; }
+};
+
+class Benchmarks {
+public:
+    // the ofxOpenCv threshold, dilate, blur and erode chain against DepthMorphology at 320x240, 640x480 //
+    // and 512x424, counted per frame. Every frame is checked to match pixel for pixel //
+    static vector< BenchmarkResult > runMorphology( const DepthMorphology::Settings& asettings, int anumPasses = 200 );
+    
+    // counts the motion in a anumCols x anumRows grid of hit boxes on a 320x240 mask, with countNonZeroInRegion() //
+    // per box and with an IntegralImage built once per frame, counted per frame. The counts are checked to match //
+    static vector< BenchmarkResult > runHitBoxes( int anumCols, int anumRows, int anumPasses = 200 );
+    
+    // rasterizes anumZones random polygons at 320x240 and counts a motion and depth mask into them, //
+    // counted per frame. The zone map is checked against ofPolyline::inside() at every pixel centre //
+    static vector< BenchmarkResult > runZones( int anumZones, int anumPasses = 200 );
+    
+    // a 640x480 raw depth frame to the flipped 320x240 gray image, through the kinect's 8 bit depth copied into //
+    // ofxOpenCv and through a DepthIngest, counted per frame. The results are checked to match //
+    static vector< BenchmarkResult > runDepthIngest( int anearMm, int afarMm, int anumPasses = 200 );
+    
+    static void log( const vector<BenchmarkResult>& aresults );
+};
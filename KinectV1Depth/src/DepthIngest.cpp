@@ -0,0 +1,56 @@
+//
+//  DepthIngest.cpp
+//  KinectV1Depth
+//
+
+#include "DepthIngest.h"
+
+//--------------------------------------------------------------
+void DepthIngest::setClipping( int anearMm, int afarMm ) {
+    if( anearMm == nearClip && afarMm == farClip && grayLookup.size() ) return;
+    nearClip = anearMm;
+    farClip = afarMm;
+    // as ofxKinect::updateDepthLookupTable(), near is white and 0 stays black //
+    grayLookup.resize( MAX_DEPTH_MM + 1 );
+    grayLookup[0] = 0;
+    for( int i = 1; i <= MAX_DEPTH_MM; i++ ) {
+        grayLookup[i] = ofMap( i, nearClip, farClip, 255, 0, true );
+    }
+}
+
+//--------------------------------------------------------------
+void DepthIngest::process( const uint16_t* araw, int awidth, int aheight, bool abFlipX, bool abFlipY, ofPixels& adepth, ofShortPixels& adepthMm ) {
+    if( grayLookup.empty() ) {
+        setClipping( 500, 4000 );
+    }
+    int width = awidth / 2;
+    int height = aheight / 2;
+    if( adepth.getWidth() != (size_t)width || adepth.getHeight() != (size_t)height || adepth.getNumChannels() != 1 ) {
+        adepth.allocate( width, height, 1 );
+    }
+    if( adepthMm.getWidth() != (size_t)width || adepthMm.getHeight() != (size_t)height || adepthMm.getNumChannels() != 1 ) {
+        adepthMm.allocate( width, height, 1 );
+    }
+    if( width <= 0 || height <= 0 ) return;
+    
+    const uint8_t* lookup = &grayLookup[0];
+    // 2^32 / n rounded up, exact for sums of up to 4 readings, 0 for no readings //
+    static const uint64_t reciprocals[5] = { 0, 0x100000000ull, 0x80000000ull, 0x55555556ull, 0x40000000ull };
+    for( int y = 0; y < height; y++ ) {
+        const uint16_t* r0 = araw + (size_t)(2*y) * awidth;
+        const uint16_t* r1 = r0 + awidth;
+        int ty = abFlipY ? height-1-y : y;
+        uint8_t* gray = adepth.getData() + (size_t)ty * width;
+        uint16_t* mm = adepthMm.getData() + (size_t)ty * width;
+        for( int x = 0; x < width; x++ ) {
+            uint16_t a = std::min( r0[2*x], (uint16_t)MAX_DEPTH_MM );
+            uint16_t b = std::min( r0[2*x+1], (uint16_t)MAX_DEPTH_MM );
+            uint16_t c = std::min( r1[2*x], (uint16_t)MAX_DEPTH_MM );
+            uint16_t d = std::min( r1[2*x+1], (uint16_t)MAX_DEPTH_MM );
+            int tx = abFlipX ? width-1-x : x;
+            gray[tx] = (lookup[a] + lookup[b] + lookup[c] + lookup[d] + 2) >> 2;
+            int numReadings = (a != 0) + (b != 0) + (c != 0) + (d != 0);
+            mm[tx] = ((a + b + c + d + numReadings/2) * reciprocals[numReadings]) >> 32;
+        }
+    }
+}
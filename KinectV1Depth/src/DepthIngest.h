@@ -0,0 +1,33 @@
+//
+//  DepthIngest.h
+//  KinectV1Depth
+//
+//  Turns the kinect's raw depth, in mm, into the half size gray image the cv
+//  chain works on, in one pass straight from the driver's buffer: clipped to
+//  near / far with near white like ofxKinect's 8 bit depth, mirrored and
+//  scaled down by averaging 2x2 pixels like scaleIntoMe( CV_INTER_LINEAR ).
+//  The mm depth is kept at the same size for the later stages.
+//
+
+#pragma once
+#include "ofMain.h"
+
+class DepthIngest {
+public:
+    // the largest raw depth the kinect reports //
+    static const int MAX_DEPTH_MM = 10000;
+    
+    void setClipping( int anearMm, int afarMm );
+    int getNearClipping() const { return nearClip; }
+    int getFarClipping() const { return farClip; }
+    
+    // araw is awidth x aheight mm, 0 where there is no reading. adepth and adepthMm are allocated //
+    // to awidth/2 x aheight/2, adepthMm is the mean of the readings of each 2x2 block, 0 if there were none //
+    void process( const uint16_t* araw, int awidth, int aheight, bool abFlipX, bool abFlipY, ofPixels& adepth, ofShortPixels& adepthMm );
+    
+protected:
+    int nearClip = -1;
+    int farClip = -1;
+    // mm to 8 bit gray //
+    vector< uint8_t > grayLookup;
+};
@@ -0,0 +1,266 @@
+//
+//  DepthMorphology.cpp
+//  KinectV1Depth
+//
+
+#include "DepthMorphology.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MORPHOLOGY_USE_SSE
+#endif
+
+// working set of a strip, the two byte buffers and the row sums //
+static const size_t STRIP_BYTES = 2 * 1024 * 1024;
+
+//--------------------------------------------------------------
+void DepthMorphology::getGaussianKernel( int asize, vector<uint16_t>& acoeffs ) {
+    acoeffs.clear();
+    if( asize <= 1 ) return;
+    asize |= 1;
+    // as cv::getGaussianKernel with sigma 0, in float, then converted to 8 bit fixed point //
+    static const float smallKernels[][7] = {
+        {1.f},
+        {0.25f, 0.5f, 0.25f},
+        {0.0625f, 0.25f, 0.375f, 0.25f, 0.0625f},
+        {0.03125f, 0.109375f, 0.21875f, 0.28125f, 0.21875f, 0.109375f, 0.03125f}
+    };
+    vector< float > tkernel( asize );
+    double sigma = ((asize-1)*0.5 - 1)*0.3 + 0.8;
+    double scale2 = -0.5 / (sigma * sigma);
+    double sum = 0;
+    for( int i = 0; i < asize; i++ ) {
+        double x = i - (asize-1)*0.5;
+        tkernel[i] = asize <= 7 ? smallKernels[asize>>1][i] : (float)std::exp( scale2*x*x );
+        sum += tkernel[i];
+    }
+    sum = 1./sum;
+    acoeffs.resize( asize );
+    for( int i = 0; i < asize; i++ ) {
+        float tvalue = (float)(tkernel[i]*sum);
+        acoeffs[i] = (uint16_t)lrintf( tvalue * 256.f );
+    }
+}
+
+//--------------------------------------------------------------
+int DepthMorphology::getHaloRows( const Settings& asettings ) {
+    int radius = asettings.blurSize > 1 ? (asettings.blurSize | 1) / 2 : 0;
+    // dilate and erode reach a row each, the blur its radius //
+    return std::max( asettings.numPasses, 0 ) * (radius + 2);
+}
+
+//--------------------------------------------------------------
+void DepthMorphology::process( const uint8_t* asrc, size_t asrcStride, uint8_t* adst, size_t adstStride, int awidth, int aheight, const Settings& asettings ) {
+    if( awidth <= 0 || aheight <= 0 ) return;
+    
+    int blurSize = asettings.blurSize > 1 ? (asettings.blurSize | 1) : 0;
+    if( blurSize != kernelSize ) {
+        getGaussianKernel( blurSize, kernel );
+        kernelSize = blurSize;
+    }
+    int halo = getHaloRows( asettings );
+    int stripRows = asettings.stripRows;
+    if( stripRows <= 0 ) {
+        int localRows = (int)(STRIP_BYTES / (4 * (size_t)awidth));
+        // never less than the halo, the overlap would be most of the work //
+        stripRows = std::max( localRows - 2*halo, std::max( 2*halo, 16 ) );
+    }
+    if( stripRows + 2*halo >= aheight ) {
+        stripRows = aheight;
+    }
+    int maxLocalRows = std::min( stripRows + 2*halo, aheight );
+    
+    width = awidth;
+    size_t localSize = (size_t)maxLocalRows * awidth;
+    if( bufferA.size() < localSize ) {
+        bufferA.resize( localSize );
+        bufferB.resize( localSize );
+    }
+    if( kernelSize && rowSums.size() < localSize ) {
+        rowSums.resize( localSize );
+    }
+    paddedRow.resize( awidth + std::max( kernelSize, 3 ) );
+    
+    for( int y0 = 0; y0 < aheight; y0 += stripRows ) {
+        int y1 = std::min( y0 + stripRows, aheight );
+        int first = std::max( y0 - halo, 0 );
+        int last = std::min( y1 + halo, aheight );
+        int rows = last - first;
+        
+        uint8_t* current = &bufferA[0];
+        uint8_t* other = &bufferB[0];
+        threshold( asrc + first * asrcStride, asrcStride, current, rows, asettings.threshold );
+        for( int pass = 0; pass < asettings.numPasses; pass++ ) {
+            morph3x3( current, other, rows, true );
+            std::swap( current, other );
+            if( kernelSize ) {
+                blur( current, other, rows );
+                std::swap( current, other );
+            }
+            morph3x3( current, other, rows, false );
+            std::swap( current, other );
+        }
+        
+        for( int y = y0; y < y1; y++ ) {
+            memcpy( adst + y * adstStride, current + (size_t)(y - first) * awidth, awidth );
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void DepthMorphology::threshold( const uint8_t* asrc, size_t asrcStride, uint8_t* adst, int arows, int athreshold ) {
+    // as cvThreshold( CV_THRESH_BINARY ), 255 above the threshold //
+    if( athreshold < 0 || athreshold >= 255 ) {
+        memset( adst, athreshold < 0 ? 255 : 0, (size_t)arows * width );
+        return;
+    }
+    uint8_t tthreshold = (uint8_t)athreshold;
+    for( int y = 0; y < arows; y++ ) {
+        const uint8_t* __restrict src = asrc + y * asrcStride;
+        uint8_t* __restrict dst = adst + (size_t)y * width;
+        int x = 0;
+#ifdef MORPHOLOGY_USE_SSE
+        // src > t is max( src, t+1 ) == src //
+        __m128i vthreshold = _mm_set1_epi8( (char)(tthreshold + 1) );
+        for( ; x + 16 <= width; x += 16 ) {
+            __m128i v = _mm_loadu_si128( (const __m128i*)(src + x) );
+            _mm_storeu_si128( (__m128i*)(dst + x), _mm_cmpeq_epi8( _mm_max_epu8( v, vthreshold ), v ) );
+        }
+#endif
+        for( ; x < width; x++ ) {
+            dst[x] = src[x] > tthreshold ? 255 : 0;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void DepthMorphology::morph3x3( const uint8_t* asrc, uint8_t* adst, int arows, bool abMax ) {
+    // the column max or min of three rows into paddedRow, then across three columns //
+    uint8_t* __restrict column = &paddedRow[0];
+    for( int y = 0; y < arows; y++ ) {
+        const uint8_t* __restrict r0 = asrc + (size_t)std::max( y-1, 0 ) * width;
+        const uint8_t* __restrict r1 = asrc + (size_t)y * width;
+        const uint8_t* __restrict r2 = asrc + (size_t)std::min( y+1, arows-1 ) * width;
+        uint8_t* __restrict dst = adst + (size_t)y * width;
+        
+        int x = 0;
+#ifdef MORPHOLOGY_USE_SSE
+        for( ; x + 16 <= width; x += 16 ) {
+            __m128i a = _mm_loadu_si128( (const __m128i*)(r0 + x) );
+            __m128i b = _mm_loadu_si128( (const __m128i*)(r1 + x) );
+            __m128i c = _mm_loadu_si128( (const __m128i*)(r2 + x) );
+            __m128i v = abMax ? _mm_max_epu8( _mm_max_epu8( a, b ), c ) : _mm_min_epu8( _mm_min_epu8( a, b ), c );
+            _mm_storeu_si128( (__m128i*)(column + 1 + x), v );
+        }
+#endif
+        if( abMax ) {
+            for( ; x < width; x++ ) column[1+x] = std::max( std::max( r0[x], r1[x] ), r2[x] );
+        } else {
+            for( ; x < width; x++ ) column[1+x] = std::min( std::min( r0[x], r1[x] ), r2[x] );
+        }
+        // replicated border //
+        column[0] = column[1];
+        column[width+1] = column[width];
+        
+        x = 0;
+#ifdef MORPHOLOGY_USE_SSE
+        for( ; x + 16 <= width; x += 16 ) {
+            __m128i a = _mm_loadu_si128( (const __m128i*)(column + x) );
+            __m128i b = _mm_loadu_si128( (const __m128i*)(column + x + 1) );
+            __m128i c = _mm_loadu_si128( (const __m128i*)(column + x + 2) );
+            __m128i v = abMax ? _mm_max_epu8( _mm_max_epu8( a, b ), c ) : _mm_min_epu8( _mm_min_epu8( a, b ), c );
+            _mm_storeu_si128( (__m128i*)(dst + x), v );
+        }
+#endif
+        if( abMax ) {
+            for( ; x < width; x++ ) dst[x] = std::max( std::max( column[x], column[x+1] ), column[x+2] );
+        } else {
+            for( ; x < width; x++ ) dst[x] = std::min( std::min( column[x], column[x+1] ), column[x+2] );
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void DepthMorphology::blur( const uint8_t* asrc, uint8_t* adst, int arows ) {
+    const int radius = kernelSize / 2;
+    const uint16_t* k = &kernel[0];
+    int kernelSum = 0;
+    for( int i = 0; i < kernelSize; i++ ) kernelSum += k[i];
+    
+    // rows, sums of pixels times 1/256ths, at most 255 * 257 so they fit 16 bits. The kernel is //
+    // symmetric, pixels the same distance from the centre are added before multiplying //
+    uint8_t* __restrict padded = &paddedRow[0];
+    for( int y = 0; y < arows; y++ ) {
+        const uint8_t* src = asrc + (size_t)y * width;
+        uint16_t* __restrict sums = &rowSums[ (size_t)y * width ];
+        memset( padded, src[0], radius );
+        memcpy( padded + radius, src, width );
+        memset( padded + radius + width, src[width-1], radius );
+        
+        int x = 0;
+#ifdef MORPHOLOGY_USE_SSE
+        __m128i zero = _mm_setzero_si128();
+        // stored offset by 32768 for the signed multiply adds of the column pass //
+        __m128i bias = _mm_set1_epi16( (short)0x8000 );
+        for( ; x + 16 <= width; x += 16 ) {
+            __m128i v = _mm_loadu_si128( (const __m128i*)(padded + x + radius) );
+            __m128i vk = _mm_set1_epi16( (short)k[radius] );
+            __m128i lo = _mm_mullo_epi16( _mm_unpacklo_epi8( v, zero ), vk );
+            __m128i hi = _mm_mullo_epi16( _mm_unpackhi_epi8( v, zero ), vk );
+            for( int i = 0; i < radius; i++ ) {
+                __m128i a = _mm_loadu_si128( (const __m128i*)(padded + x + i) );
+                __m128i b = _mm_loadu_si128( (const __m128i*)(padded + x + kernelSize - 1 - i) );
+                vk = _mm_set1_epi16( (short)k[i] );
+                lo = _mm_add_epi16( lo, _mm_mullo_epi16( _mm_add_epi16( _mm_unpacklo_epi8( a, zero ), _mm_unpacklo_epi8( b, zero ) ), vk ) );
+                hi = _mm_add_epi16( hi, _mm_mullo_epi16( _mm_add_epi16( _mm_unpackhi_epi8( a, zero ), _mm_unpackhi_epi8( b, zero ) ), vk ) );
+            }
+            _mm_storeu_si128( (__m128i*)(sums + x), _mm_xor_si128( lo, bias ) );
+            _mm_storeu_si128( (__m128i*)(sums + x + 8), _mm_xor_si128( hi, bias ) );
+        }
+#endif
+        for( ; x < width; x++ ) {
+            uint32_t sum = k[radius] * padded[x + radius];
+            for( int i = 0; i < radius; i++ ) {
+                sum += k[i] * (padded[x + i] + padded[x + kernelSize - 1 - i]);
+            }
+            sums[x] = (uint16_t)(sum ^ 0x8000);
+        }
+    }
+    
+    // columns, rounded off the 16 bit fraction like FixedPtCastEx //
+    const uint16_t* rows[ 64 ];
+    int tsize = std::min( kernelSize, 64 );
+    for( int y = 0; y < arows; y++ ) {
+        for( int i = 0; i < tsize; i++ ) {
+            int ty = std::min( std::max( y + i - radius, 0 ), arows-1 );
+            rows[i] = &rowSums[ (size_t)ty * width ];
+        }
+        uint8_t* __restrict dst = adst + (size_t)y * width;
+        
+        int x = 0;
+#ifdef MORPHOLOGY_USE_SSE
+        // two rows at a time, the sums as signed values plus the rounding and the 32768 * coefficient they were offset by //
+        __m128i offset = _mm_set1_epi32( (1 << 15) + (kernelSum << 15) );
+        for( ; x + 8 <= width; x += 8 ) {
+            __m128i lo = offset;
+            __m128i hi = offset;
+            for( int i = 0; i < tsize; i += 2 ) {
+                __m128i a = _mm_loadu_si128( (const __m128i*)(rows[i] + x) );
+                __m128i b = i+1 < tsize ? _mm_loadu_si128( (const __m128i*)(rows[i+1] + x) ) : _mm_setzero_si128();
+                __m128i vk = _mm_set1_epi32( (int)k[i] | (i+1 < tsize ? (int)k[i+1] << 16 : 0) );
+                lo = _mm_add_epi32( lo, _mm_madd_epi16( _mm_unpacklo_epi16( a, b ), vk ) );
+                hi = _mm_add_epi32( hi, _mm_madd_epi16( _mm_unpackhi_epi16( a, b ), vk ) );
+            }
+            __m128i packed = _mm_packs_epi32( _mm_srli_epi32( lo, 16 ), _mm_srli_epi32( hi, 16 ) );
+            _mm_storel_epi64( (__m128i*)(dst + x), _mm_packus_epi16( packed, packed ) );
+        }
+#endif
+        for( ; x < width; x++ ) {
+            uint32_t sum = 1 << 15;
+            for( int i = 0; i < tsize; i++ ) {
+                sum += (uint32_t)k[i] * (rows[i][x] ^ 0x8000);
+            }
+            dst[x] = (uint8_t)std::min( sum >> 16, 255u );
+        }
+    }
+}
@@ -0,0 +1,56 @@
+//
+//  DepthMorphology.h
+//  KinectV1Depth
+//
+//  The threshold, dilate, blur and erode chain in one call, with the same
+//  result pixel for pixel as ofxCvGrayscaleImage::threshold() followed by
+//  numPasses of dilate(), blurGaussian() and erode_3x3() (OpenCV 2.4: 3x3 max
+//  and min, 8 bit fixed point gaussian, replicated borders).
+//
+//  The steps work out of two buffers of their own instead of a full image pass
+//  through ofxCvImage per step. Images bigger than the kinect's are done in
+//  strips of rows that stay in cache through every step, each read with enough
+//  rows above and below that the steps do not reach past them. The loops use
+//  SSE2 where it is available and are kept simple enough for the compiler to
+//  vectorize elsewhere (NEON).
+//
+
+#pragma once
+#include "ofMain.h"
+
+class DepthMorphology {
+public:
+    class Settings {
+    public:
+        int threshold = 50;
+        int numPasses = 2;
+        // gaussian kernel size as passed to blurGaussian(), 1 or less for no blur //
+        int blurSize = 7;
+        // rows per strip, 0 picks them from the image size //
+        int stripRows = 0;
+    };
+    
+    // adst can not be asrc, strides in bytes //
+    void process( const uint8_t* asrc, size_t asrcStride, uint8_t* adst, size_t adstStride, int awidth, int aheight, const Settings& asettings );
+    
+    // the coefficients cvSmooth( CV_GAUSSIAN, asize ) uses, in 1/256ths //
+    static void getGaussianKernel( int asize, vector<uint16_t>& acoeffs );
+    // rows the strips are extended by for asettings //
+    static int getHaloRows( const Settings& asettings );
+
+protected:
+    void threshold( const uint8_t* asrc, size_t asrcStride, uint8_t* adst, int arows, int athreshold );
+    // 3x3 max or min //
+    void morph3x3( const uint8_t* asrc, uint8_t* adst, int arows, bool abMax );
+    void blur( const uint8_t* asrc, uint8_t* adst, int arows );
+    
+    int width = 0;
+    vector< uint8_t > bufferA;
+    vector< uint8_t > bufferB;
+    // gaussian row pass results, 8 bit fraction //
+    vector< uint16_t > rowSums;
+    // a row with its borders replicated //
+    vector< uint8_t > paddedRow;
+    int kernelSize = 0;
+    vector< uint16_t > kernel;
+};
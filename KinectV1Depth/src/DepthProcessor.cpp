@@ -0,0 +1,305 @@
+//
+//  DepthProcessor.cpp
+//  KinectV1Depth
+//
+
+#include "DepthProcessor.h"
+#include "FrameProfiler.h"
+
+//--------------------------------------------------------------
+DepthProcessor::~DepthProcessor() {
+    close();
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::setup( const vector<HitBox>& ahitBoxes ) {
+    close();
+    hitBoxes = ahitBoxes;
+    hitRegions.clear();
+    // there is no gl context on the worker thread //
+    colorCv.setUseTexture( false );
+    grayCv.setUseTexture( false );
+    scaledCv.setUseTexture( false );
+    processedCv[0].setUseTexture( false );
+    processedCv[1].setUseTexture( false );
+    historyCv.setUseTexture( false );
+    startThread();
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::close() {
+    stopThread();
+    {
+        std::lock_guard< std::mutex > lock( wakeMutex );
+        bWake = true;
+    }
+    wakeCondition.notify_one();
+    waitForThread( false );
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::setZones( const vector<Zone>& azones ) {
+    std::lock_guard< std::mutex > lock( zonesMutex );
+    pendingZones = azones;
+    bZonesChanged = true;
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::submit() {
+    DepthInput& input   = inputs.getWriteBuffer();
+    input.frameNum      = numSubmitted++;
+    input.submitMicros  = ofGetElapsedTimeMicros();
+    inputs.publish();
+    {
+        std::lock_guard< std::mutex > lock( wakeMutex );
+        bWake = true;
+    }
+    wakeCondition.notify_one();
+}
+
+//--------------------------------------------------------------
+bool DepthProcessor::update() {
+    if( !results.update() ) return false;
+    const DepthResult& result = results.getReadBuffer();
+    numResults++;
+    latencySumMs += result.latencyMs;
+    latencyMaxMs = std::max( latencyMaxMs, result.latencyMs );
+    return true;
+}
+
+//--------------------------------------------------------------
+DepthProcessor::Stats DepthProcessor::getStats() const {
+    Stats tstats;
+    tstats.numSubmitted         = numSubmitted;
+    tstats.numProcessed         = numProcessed;
+    tstats.numDroppedInputs     = inputs.getNumOverwritten();
+    tstats.numDroppedResults    = results.getNumOverwritten();
+    if( numResults ) {
+        const DepthResult& result = results.getReadBuffer();
+        tstats.latencyMs    = result.latencyMs;
+        tstats.processMs    = result.processMs;
+        tstats.latencyAvgMs = (float)(latencySumMs / numResults);
+        tstats.latencyMaxMs = latencyMaxMs;
+    }
+    return tstats;
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::threadedFunction() {
+    FrameProfiler::get().setThreadName( "depth" );
+    while( isThreadRunning() ) {
+        {
+            std::unique_lock< std::mutex > lock( wakeMutex );
+            wakeCondition.wait_for( lock, std::chrono::milliseconds(100), [this]() { return bWake; } );
+            bWake = false;
+        }
+        // only the newest frame, anything older was replaced //
+        if( !inputs.update() ) continue;
+        const DepthInput& input = inputs.getReadBuffer();
+        DepthResult& result = results.getWriteBuffer();
+        
+        uint64_t startMicros = ofGetElapsedTimeMicros();
+        process( input, result );
+        uint64_t endMicros = ofGetElapsedTimeMicros();
+        result.frameNum     = input.frameNum;
+        result.processMs    = (endMicros - startMicros) / 1000.f;
+        result.latencyMs    = (endMicros - input.submitMicros) / 1000.f;
+        results.publish();
+        numProcessed++;
+    }
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::process( const DepthInput& ainput, DepthResult& aresult ) {
+    PROFILE_SCOPE( "cv" );
+    const DepthSettings& settings = ainput.settings;
+    const ofPixels& pixels = ainput.pixels;
+    
+    // the gray image at the processing size the chain starts from //
+    const uint8_t* scaledData = NULL;
+    size_t scaledStride = 0;
+    int width = 0;
+    int height = 0;
+    if( ainput.depth.isAllocated() ) {
+        // the kinect, clipped, flipped and scaled already, used as it is //
+        scaledData      = ainput.depth.getData();
+        width           = ainput.depth.getWidth();
+        height          = ainput.depth.getHeight();
+        scaledStride    = width;
+    } else {
+        if( !pixels.isAllocated() ) return;
+        if( pixels.getNumChannels() == 3 ) {
+            // allocate the cv images to the size of the video pixels //
+            if( colorCv.getWidth() != pixels.getWidth() ) {
+                colorCv.allocate( pixels.getWidth(), pixels.getHeight() );
+                grayCv.allocate( pixels.getWidth(), pixels.getHeight() );
+            }
+            // the video comes in as RGB
+            colorCv.setFromPixels( pixels );
+            // converts from color to gray
+            grayCv = colorCv;
+        } else {
+            grayCv.setFromPixels( pixels );
+        }
+        
+        if( settings.bFlipX || settings.bFlipY ){
+            grayCv.mirror( settings.bFlipY, settings.bFlipX );
+        }
+        
+        if( scaledCv.getWidth() == 0 ) {
+            scaledCv.allocate( grayCv.getWidth()/2, grayCv.getHeight()/2 );
+        }
+        // perform operations at a smaller size //
+        scaledCv.scaleIntoMe( grayCv, CV_INTER_LINEAR );
+        IplImage* scaled = scaledCv.getCvImage();
+        scaledData      = (const uint8_t*)scaled->imageData;
+        scaledStride    = scaled->widthStep;
+        width           = scaled->width;
+        height          = scaled->height;
+    }
+    if( width <= 0 || height <= 0 ) return;
+    
+    if( processedCv[0].getWidth() != width || processedCv[0].getHeight() != height ) {
+        processedCv[0].allocate( width, height );
+        processedCv[1].allocate( width, height );
+        bHasPrevFrame = false;
+    }
+    
+    // last frame's result becomes the previous frame //
+    processedIndex = 1 - processedIndex;
+    ofxCvGrayscaleImage& processed = processedCv[processedIndex];
+    ofxCvGrayscaleImage& prevFrame = processedCv[1-processedIndex];
+    
+    {
+        PROFILE_SCOPE( "morphology" );
+        // threshold, then dilate, blur and erode numDilatePasses times in one go //
+        DepthMorphology::Settings morphSettings;
+        morphSettings.threshold = settings.threshold;
+        morphSettings.numPasses = settings.numDilatePasses;
+        morphSettings.blurSize  = settings.blurAmount > 0 ? settings.blurAmount*2+1 : 0;
+        IplImage* dst = processed.getCvImage();
+        morphology.process( scaledData, scaledStride, (uint8_t*)dst->imageData, dst->widthStep, width, height, morphSettings );
+        processed.flagImageChanged();
+    }
+    
+    if( bHasPrevFrame ) {
+        historyCv.absDiff( prevFrame, processed );
+    }
+    bHasPrevFrame = true;
+    
+    {
+        PROFILE_SCOPE( "find contours" );
+        finder.findContours( processed, settings.minSize*settings.minSize, settings.maxSize*settings.maxSize, 20, true, false );
+    }
+    
+    PROFILE_SCOPE( "contours and boxes" );
+    aresult.contours.clear();
+    // copy the contours and apply some smoothing //
+    vector< ofxCvBlob >& blobs = finder.blobs;
+    for( size_t d = 0; d < blobs.size(); d++ ) {
+        ofPolyline tempPoly;
+        tempPoly.addVertices( blobs[d].pts );
+        if( tempPoly.getPerimeter() > settings.contourPolySpacing ) {
+            tempPoly = tempPoly.getResampledBySpacing( settings.contourPolySpacing );
+        }
+        if( settings.contourSmoothing > 0 ) {
+            tempPoly = tempPoly.getSmoothed( settings.contourSmoothing );
+        }
+        aresult.contours.push_back( tempPoly );
+    }
+    
+    // all of the contours are relative to the width and height of the kinect depth image
+    // convert them to screen space //
+    if( settings.bScreenSpace ) {
+        float xscale = settings.screenWidth / processed.getWidth();
+        float yscale = settings.screenHeight / processed.getHeight();
+        for( auto& contour : aresult.contours ) {
+            // loop through all of the vertices and scale them //
+            for( auto& vertex : contour.getVertices() ) {
+                vertex.x *= xscale;
+                vertex.y *= yscale;
+            }
+        }
+        
+        PROFILE_SCOPE( "hit boxes" );
+        if( historyCv.bAllocated ) {
+            IplImage* history = historyCv.getCvImage();
+            historyIntegral.build( (const uint8_t*)history->imageData, history->widthStep, history->width, history->height );
+        } else {
+            historyIntegral.clear();
+        }
+        updateHitRegions( settings, processed.getWidth(), processed.getHeight() );
+        uint32_t minPixels = settings.minPixToActivateBox*settings.minPixToActivateBox;
+        // check the motion history to see if one of the boxes should be hit //
+        for( size_t i = 0; i < hitBoxes.size(); i++ ) {
+            HitBox& hitBox = hitBoxes[i];
+            if( historyIntegral.getCount( hitRegions[i] ) > minPixels ) {
+                hitBox.hitPct += 0.1;
+            } else {
+                hitBox.hitPct -= 0.01;
+            }
+            hitBox.hitPct = ofClamp( hitBox.hitPct, 0.0, 1.0 );
+        }
+    }
+    aresult.hitBoxes = hitBoxes;
+    
+    {
+        std::lock_guard< std::mutex > lock( zonesMutex );
+        if( bZonesChanged ) {
+            zoneMap.setZones( pendingZones );
+            zoneStates.clear();
+            bZonesChanged = false;
+        }
+    }
+    if( zoneMap.getZones().size() ) {
+        PROFILE_SCOPE( "zones" );
+        zoneMap.update( processed.getWidth(), processed.getHeight() );
+        IplImage* present = processed.getCvImage();
+        IplImage* motion = historyCv.bAllocated ? historyCv.getCvImage() : NULL;
+        const ofShortPixels& depthMm = ainput.depthMm;
+        bool bHasDepthMm = depthMm.getWidth() == (size_t)width && depthMm.getHeight() == (size_t)height;
+        zoneMap.count( motion ? (const uint8_t*)motion->imageData : NULL, motion ? motion->widthStep : 0,
+                      (const uint8_t*)present->imageData, present->widthStep,
+                      bHasDepthMm ? depthMm.getData() : NULL, bHasDepthMm ? depthMm.getWidth() : 0, zoneStates );
+        uint32_t minPixels = settings.minPixToActivateBox*settings.minPixToActivateBox;
+        for( auto& zone : zoneStates ) {
+            if( zone.numMotion > minPixels ) {
+                zone.activePct += 0.1;
+            } else {
+                zone.activePct -= 0.01;
+            }
+            zone.activePct = ofClamp( zone.activePct, 0.0, 1.0 );
+        }
+    }
+    aresult.zones = zoneStates;
+    
+    aresult.processed = processed.getPixels();
+    if( historyCv.bAllocated ) {
+        aresult.history = historyCv.getPixels();
+    }
+}
+
+//--------------------------------------------------------------
+void DepthProcessor::updateHitRegions( const DepthSettings& asettings, int acvWidth, int acvHeight ) {
+    if( hitRegions.size() == hitBoxes.size() &&
+       hitRegionsScreenWidth == asettings.screenWidth && hitRegionsScreenHeight == asettings.screenHeight &&
+       hitRegionsCvWidth == acvWidth && hitRegionsCvHeight == acvHeight ) {
+        return;
+    }
+    hitRegionsScreenWidth   = asettings.screenWidth;
+    hitRegionsScreenHeight  = asettings.screenHeight;
+    hitRegionsCvWidth       = acvWidth;
+    hitRegionsCvHeight      = acvHeight;
+    
+    float rxscale = acvWidth / asettings.screenWidth;
+    float ryscale = acvHeight / asettings.screenHeight;
+    hitRegions.resize( hitBoxes.size() );
+    for( size_t i = 0; i < hitBoxes.size(); i++ ) {
+        // truncated the way countNonZeroInRegion() took them //
+        const ofRectangle& rect = hitBoxes[i].rectangle;
+        hitRegions[i].x         = rect.x * rxscale;
+        hitRegions[i].y         = rect.y * ryscale;
+        hitRegions[i].width     = rect.width * rxscale;
+        hitRegions[i].height    = rect.height * ryscale;
+    }
+}
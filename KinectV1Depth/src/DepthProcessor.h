@@ -0,0 +1,154 @@
+//
+//  DepthProcessor.h
+//  KinectV1Depth
+//
+//  Runs the cv chain on a worker thread so a slow depth frame does not hold up
+//  drawing: threshold, dilate / blur / erode, frame difference, contours and
+//  the hit boxes, counted from an integral image of the frame difference, and
+//  the polygon zones of a ZoneMap. The main thread submits frames and takes
+//  the newest result, both through triple buffers, so neither side waits
+//  on the other. Frames that arrive while the worker is busy replace the
+//  waiting one.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOpenCv.h"
+#include "TripleBuffer.h"
+#include "DepthMorphology.h"
+#include "IntegralImage.h"
+#include "ZoneMap.h"
+
+class HitBox {
+public:
+    ofRectangle rectangle;
+    float hitPct = 0.0;
+};
+
+// the gui values a frame is processed with //
+class DepthSettings {
+public:
+    int numDilatePasses = 2;
+    int blurAmount = 3;
+    int threshold = 50;
+    float minSize = 10;
+    float maxSize = 600;
+    int contourPolySpacing = 3;
+    int contourSmoothing = 1;
+    int minPixToActivateBox = 20;
+    bool bFlipX = false;
+    bool bFlipY = false;
+    // contours scaled to the screen and hit boxes updated, otherwise contours stay in cv space //
+    bool bScreenSpace = false;
+    float screenWidth = 1024;
+    float screenHeight = 768;
+};
+
+class DepthInput {
+public:
+    // the kinect's depth at the processing size, clipped and flipped by a DepthIngest //
+    ofPixels depth;
+    // the same in mm //
+    ofShortPixels depthMm;
+    // otherwise full size gray or rgb video //
+    ofPixels pixels;
+    DepthSettings settings;
+    uint64_t frameNum = 0;
+    uint64_t submitMicros = 0;
+};
+
+class DepthResult {
+public:
+    ofPixels processed;
+    ofPixels history;
+    vector< ofPolyline > contours;
+    vector< HitBox > hitBoxes;
+    // one per zone given to setZones() //
+    vector< ZoneState > zones;
+    uint64_t frameNum = 0;
+    // submit to result //
+    float latencyMs = 0;
+    float processMs = 0;
+};
+
+class DepthProcessor : public ofThread {
+public:
+    class Stats {
+    public:
+        uint64_t numSubmitted = 0;
+        uint64_t numProcessed = 0;
+        // replaced by a newer frame before the worker got to them //
+        uint64_t numDroppedInputs = 0;
+        // replaced by a newer result before the main thread took them //
+        uint64_t numDroppedResults = 0;
+        float latencyMs = 0;
+        float latencyAvgMs = 0;
+        float latencyMaxMs = 0;
+        float processMs = 0;
+    };
+    
+    ~DepthProcessor();
+    
+    // ahitBoxes in screen space, their hitPct is kept by the worker //
+    void setup( const vector<HitBox>& ahitBoxes );
+    void close();
+    
+    // main thread, picked up with the next frame, the zone states start over //
+    void setZones( const vector<Zone>& azones );
+    
+    // main thread, fill the input and submit it //
+    DepthInput& getInput() { return inputs.getWriteBuffer(); }
+    void submit();
+    
+    // main thread, true if a new result came in since the last call //
+    bool update();
+    // main thread, valid until the next update() //
+    const DepthResult& getResult() const { return results.getReadBuffer(); }
+    Stats getStats() const;
+
+protected:
+    void threadedFunction();
+    void process( const DepthInput& ainput, DepthResult& aresult );
+    // the hit boxes scaled into cv space, only when the screen or cv size changed //
+    void updateHitRegions( const DepthSettings& asettings, int acvWidth, int acvHeight );
+    
+    TripleBuffer< DepthInput > inputs;
+    TripleBuffer< DepthResult > results;
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool bWake = false;
+    
+    // worker thread //
+    ofxCvColorImage colorCv;
+    ofxCvGrayscaleImage grayCv;
+    ofxCvGrayscaleImage scaledCv;
+    // the current and previous frame, swapped each frame instead of copied //
+    ofxCvGrayscaleImage processedCv[2];
+    int processedIndex = 0;
+    bool bHasPrevFrame = false;
+    ofxCvGrayscaleImage historyCv;
+    DepthMorphology morphology;
+    ofxCvContourFinder finder;
+    vector< HitBox > hitBoxes;
+    // motion history counts, one lookup per hit box //
+    IntegralImage historyIntegral;
+    vector< IntegralImage::Region > hitRegions;
+    float hitRegionsScreenWidth = 0;
+    float hitRegionsScreenHeight = 0;
+    int hitRegionsCvWidth = 0;
+    int hitRegionsCvHeight = 0;
+    ZoneMap zoneMap;
+    vector< ZoneState > zoneStates;
+    atomic< uint64_t > numProcessed{0};
+    
+    // main thread to worker //
+    std::mutex zonesMutex;
+    vector< Zone > pendingZones;
+    bool bZonesChanged = false;
+    
+    // main thread //
+    uint64_t numSubmitted = 0;
+    uint64_t numResults = 0;
+    double latencySumMs = 0;
+    float latencyMaxMs = 0;
+};
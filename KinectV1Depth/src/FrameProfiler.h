@@ -0,0 +1,131 @@
+//
+//  FrameProfiler.h
+//  KinectV1Depth
+//
+//  Scoped timing markers for finding where a frame goes:
+//
+//      void ofApp::update() {
+//          PROFILE_SCOPE( "update" );
+//          ...
+//      }
+//
+//  Each thread records finished scopes into its own lock-free ring, the main
+//  thread drains them once a frame for the overlay and keeps a history that can
+//  be dumped as a Chrome trace (chrome://tracing) or CSV. While disabled a scope
+//  costs one relaxed atomic load, defining FRAME_PROFILER_OFF compiles them out.
+//  Rings are only allocated once a thread records while enabled, and the buffer
+//  of a thread that exits is reused by the next new thread.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SpscRing.h"
+
+class ProfileEvent {
+public:
+    // string literal, compared by pointer //
+    const char* name = nullptr;
+    uint64_t startNanos = 0;
+    uint64_t durationNanos = 0;
+    uint32_t thread = 0;
+};
+
+class FrameProfiler {
+public:
+    // finished scopes per thread between two drains //
+    static const size_t RING_SIZE = 1 << 14;
+    // events kept for dumping //
+    static const size_t MAX_HISTORY = 1 << 17;
+    
+    class Stat {
+    public:
+        const char* name = nullptr;
+        uint32_t thread = 0;
+        // summed over all scopes of this name in a frame //
+        float lastMs = 0;
+        float avgMs = 0;
+        float maxMs = 0;
+        uint32_t numLastFrame = 0;
+        uint32_t numThisFrame = 0;
+        uint64_t nanosThisFrame = 0;
+    };
+    
+    static FrameProfiler& get();
+    static bool isEnabled() { return bEnabled.load( std::memory_order_relaxed ); }
+    static uint64_t now();
+    
+    // call first thing in ofApp::setup(), the calling thread is thread 0 //
+    void registerMainThread();
+    void setEnabled( bool ab );
+    // any thread //
+    void record( const char* aname, uint64_t astartNanos, uint64_t aendNanos );
+    void setThreadName( const string& aname );
+    
+    // main thread, once per frame before anything is profiled //
+    void beginFrame();
+    void draw( float ax, float ay ) const;
+    bool dumpTrace( string afilePath ) const;
+    bool dumpCsv( string afilePath ) const;
+    // writes <timestamp>.json and <timestamp>.csv into adirectory //
+    void dump( string adirectory = "profiles" ) const;
+    
+protected:
+    class ThreadBuffer {
+    public:
+        uint32_t thread = 0;
+        string name;
+        // allocated by its thread on the first record() //
+        SpscRing< ProfileEvent > ring;
+        atomic< uint64_t > numDropped{0};
+        // its thread exited, free for the next one //
+        bool bRetired = false;
+    };
+    
+    // releases the buffer of its thread when the thread exits //
+    class ThreadBufferOwner {
+    public:
+        ~ThreadBufferOwner();
+        ThreadBuffer* buffer = nullptr;
+    };
+    
+    FrameProfiler();
+    ThreadBuffer* getThreadBuffer();
+    void retireThreadBuffer( ThreadBuffer* abuffer );
+    void addToHistory( const ProfileEvent& aevent );
+    
+    static atomic< bool > bEnabled;
+    
+    mutable std::mutex threadsMutex;
+    // threads[0] is the main thread's //
+    vector< unique_ptr<ThreadBuffer> > threads;
+    std::thread::id mainThreadId;
+    
+    // main thread //
+    vector< ProfileEvent > history;
+    size_t historyStart = 0;
+    vector< Stat > stats;
+    vector< ProfileEvent > drained;
+    uint64_t numDropped = 0;
+};
+
+class ProfileScope {
+public:
+    ProfileScope( const char* aname ) : name( aname ) {
+        if( FrameProfiler::isEnabled() ) start = FrameProfiler::now();
+    }
+    ~ProfileScope() {
+        if( start ) FrameProfiler::get().record( name, start, FrameProfiler::now() );
+    }
+    
+protected:
+    const char* name;
+    uint64_t start = 0;
+};
+
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#ifndef FRAME_PROFILER_OFF
+#define PROFILE_SCOPE( aname ) ProfileScope PROFILE_CONCAT( profileScope, __LINE__ )( aname )
+#else
+#define PROFILE_SCOPE( aname )
+#endif
@@ -0,0 +1,47 @@
+//
+//  IntegralImage.cpp
+//  KinectV1Depth
+//
+
+#include "IntegralImage.h"
+
+//--------------------------------------------------------------
+void IntegralImage::build( const uint8_t* asrc, size_t astride, int awidth, int aheight ) {
+    if( awidth <= 0 || aheight <= 0 ) {
+        clear();
+        return;
+    }
+    size_t stride = awidth + 1;
+    if( awidth != width || aheight != height ) {
+        width = awidth;
+        height = aheight;
+        sums.assign( stride * (height+1), 0 );
+    }
+    for( int y = 0; y < height; y++ ) {
+        const uint8_t* __restrict src = asrc + y * astride;
+        const uint32_t* __restrict above = &sums[ y * stride ];
+        uint32_t* __restrict row = &sums[ (y+1) * stride ];
+        uint32_t rowCount = 0;
+        for( int x = 0; x < width; x++ ) {
+            rowCount += src[x] != 0;
+            row[x+1] = above[x+1] + rowCount;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void IntegralImage::clear() {
+    width = height = 0;
+    sums.clear();
+}
+
+//--------------------------------------------------------------
+uint32_t IntegralImage::getCount( int ax, int ay, int aw, int ah ) const {
+    int x0 = std::max( ax, 0 );
+    int y0 = std::max( ay, 0 );
+    int x1 = std::min( ax + aw, width );
+    int y1 = std::min( ay + ah, height );
+    if( x1 <= x0 || y1 <= y0 ) return 0;
+    size_t stride = width + 1;
+    return sums[ y1 * stride + x1 ] - sums[ y0 * stride + x1 ] - sums[ y1 * stride + x0 ] + sums[ y0 * stride + x0 ];
+}
@@ -0,0 +1,39 @@
+//
+//  IntegralImage.h
+//  KinectV1Depth
+//
+//  Summed area table of the nonzero pixels of a gray image. Built in one pass,
+//  after which the nonzero count of any rectangle is four lookups, the same
+//  count ofxCvGrayscaleImage::countNonZeroInRegion() scans the rectangle for.
+//
+
+#pragma once
+#include "ofMain.h"
+
+class IntegralImage {
+public:
+    class Region {
+    public:
+        int x = 0;
+        int y = 0;
+        int width = 0;
+        int height = 0;
+    };
+    
+    // astride in bytes //
+    void build( const uint8_t* asrc, size_t astride, int awidth, int aheight );
+    void clear();
+    
+    // nonzero pixels in the rectangle, clipped to the image, 0 before build() //
+    uint32_t getCount( int ax, int ay, int aw, int ah ) const;
+    uint32_t getCount( const Region& aregion ) const { return getCount( aregion.x, aregion.y, aregion.width, aregion.height ); }
+    
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    
+protected:
+    int width = 0;
+    int height = 0;
+    // (width+1) x (height+1), the first row and column are 0 //
+    vector< uint32_t > sums;
+};
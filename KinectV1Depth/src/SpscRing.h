@@ -0,0 +1,61 @@
+//
+//  SpscRing.h
+//  KinectV1Depth
+//
+//  Lock-free ring buffer for exactly one producer thread and one consumer thread.
+//
+
+#pragma once
+#include "ofMain.h"
+
+template< typename T >
+class SpscRing {
+public:
+    // capacity is rounded up to a power of two //
+    void allocate( size_t acapacity ) {
+        size_t tsize = 1;
+        while( tsize < acapacity ) tsize <<= 1;
+        items.assign( tsize, T() );
+        mask = tsize-1;
+        head.store( 0, std::memory_order_relaxed );
+        tail.store( 0, std::memory_order_relaxed );
+    }
+    
+    // producer thread, returns false if the ring is full //
+    bool push( const T& aitem ) {
+        size_t h = head.load( std::memory_order_relaxed );
+        if( h - tail.load( std::memory_order_acquire ) > mask ) {
+            return false;
+        }
+        items[ h & mask ] = aitem;
+        head.store( h+1, std::memory_order_release );
+        return true;
+    }
+    
+    // consumer thread //
+    bool pop( T& aitem ) {
+        size_t t = tail.load( std::memory_order_relaxed );
+        if( t == head.load( std::memory_order_acquire ) ) {
+            return false;
+        }
+        aitem = items[ t & mask ];
+        tail.store( t+1, std::memory_order_release );
+        return true;
+    }
+    
+    // approximate when called while the other thread is running //
+    size_t size() const {
+        return head.load( std::memory_order_acquire ) - tail.load( std::memory_order_acquire );
+    }
+    size_t capacity() const { return items.size(); }
+    
+protected:
+    vector< T > items;
+    size_t mask = 0;
+    // padded onto separate cache lines so the two threads do not share one //
+    char pad0[64];
+    std::atomic< size_t > head{0};
+    char pad1[64];
+    std::atomic< size_t > tail{0};
+    char pad2[64];
+};
@@ -0,0 +1,56 @@
+//
+//  TripleBuffer.h
+//  KinectV1Depth
+//
+//  Hands the newest value from one producer thread to one consumer thread
+//  without either of them waiting. The producer writes into its own buffer and
+//  publishes it, the consumer takes the newest published one. Values published
+//  faster than they are taken are overwritten and counted.
+//
+
+#pragma once
+#include "ofMain.h"
+
+template< typename T >
+class TripleBuffer {
+public:
+    // producer thread, the buffer to fill before publish() //
+    T& getWriteBuffer() { return buffers[writeIndex]; }
+    
+    // producer thread //
+    void publish() {
+        uint8_t old = middle.exchange( writeIndex | NEW_BIT, std::memory_order_acq_rel );
+        writeIndex = old & INDEX_MASK;
+        if( old & NEW_BIT ) {
+            numOverwritten.fetch_add( 1, std::memory_order_relaxed );
+        }
+    }
+    
+    // consumer thread, true if a newer buffer was published since the last call //
+    bool update() {
+        if( !(middle.load( std::memory_order_relaxed ) & NEW_BIT) ) {
+            return false;
+        }
+        uint8_t old = middle.exchange( readIndex, std::memory_order_acq_rel );
+        readIndex = old & INDEX_MASK;
+        return true;
+    }
+    
+    // consumer thread, the newest value taken by update() //
+    T& getReadBuffer() { return buffers[readIndex]; }
+    const T& getReadBuffer() const { return buffers[readIndex]; }
+    
+    // published values that were never taken //
+    uint64_t getNumOverwritten() const { return numOverwritten.load( std::memory_order_relaxed ); }
+
+protected:
+    static const uint8_t INDEX_MASK = 0x03;
+    static const uint8_t NEW_BIT = 0x04;
+    
+    T buffers[3];
+    uint8_t writeIndex = 0;
+    uint8_t readIndex = 1;
+    // index of the buffer in between, with NEW_BIT set while it was not taken //
+    std::atomic< uint8_t > middle{2};
+    std::atomic< uint64_t > numOverwritten{0};
+};
@@ -0,0 +1,163 @@
+//
+//  ZoneMap.cpp
+//  KinectV1Depth
+//
+
+#include "ZoneMap.h"
+
+//--------------------------------------------------------------
+bool ZoneMap::load( string afilePath, vector<Zone>& azones ) {
+    azones.clear();
+    ofXml xml;
+    if( !xml.load( afilePath ) || !xml.setTo("zones") ) {
+        return false;
+    }
+    int numChildren = xml.getNumChildren();
+    for( int i = 0; i < numChildren; i++ ) {
+        if( !xml.setToChild( i ) ) continue;
+        if( xml.getName() == "zone" ) {
+            Zone tzone;
+            tzone.name = xml.getValue<string>( "name", "zone "+ofToString(azones.size()) );
+            vector< string > points = ofSplitString( xml.getValue<string>( "points", "" ), " ", true, true );
+            for( auto& point : points ) {
+                vector< string > coords = ofSplitString( point, "," );
+                if( coords.size() < 2 ) continue;
+                tzone.polygon.addVertex( ofToFloat(coords[0]), ofToFloat(coords[1]) );
+            }
+            tzone.polygon.close();
+            if( tzone.polygon.size() < 3 ) {
+                ofLogWarning("ZoneMap") << "load: skipping " << tzone.name << ", it needs at least 3 points";
+            } else if( azones.size() >= MAX_ZONES ) {
+                ofLogWarning("ZoneMap") << "load: skipping " << tzone.name << ", there are already " << MAX_ZONES << " zones";
+            } else {
+                azones.push_back( tzone );
+            }
+        }
+        xml.setToParent();
+    }
+    return azones.size() > 0;
+}
+
+//--------------------------------------------------------------
+void ZoneMap::setZones( const vector<Zone>& azones ) {
+    zones = azones;
+    if( zones.size() > MAX_ZONES ) {
+        zones.resize( MAX_ZONES );
+    }
+    bDirty = true;
+}
+
+//--------------------------------------------------------------
+bool ZoneMap::update( int awidth, int aheight ) {
+    if( !bDirty && awidth == width && aheight == height ) {
+        return false;
+    }
+    width = std::max( awidth, 0 );
+    height = std::max( aheight, 0 );
+    rasterize();
+    bDirty = false;
+    return true;
+}
+
+//--------------------------------------------------------------
+void ZoneMap::rasterize() {
+    labels.assign( (size_t)width * height, 0 );
+    numPixels.assign( zones.size() + 1, 0 );
+    rowSpans.assign( height, std::make_pair( width, 0 ) );
+    
+    vector< float > crossings;
+    for( size_t z = 0; z < zones.size(); z++ ) {
+        // into pixels, sampled at pixel centres with the even odd rule of ofPolyline::inside() //
+        vector< ofVec3f > verts = zones[z].polygon.getVertices();
+        if( verts.size() < 3 ) continue;
+        float miny = verts[0].y * height;
+        float maxy = miny;
+        for( auto& vert : verts ) {
+            vert.x *= width;
+            vert.y *= height;
+            miny = std::min( miny, vert.y );
+            maxy = std::max( maxy, vert.y );
+        }
+        int y0 = std::max( (int)floorf( miny ), 0 );
+        int y1 = std::min( (int)ceilf( maxy ), height );
+        uint16_t label = (uint16_t)(z + 1);
+        size_t n = verts.size();
+        for( int y = y0; y < y1; y++ ) {
+            float py = y + 0.5f;
+            crossings.clear();
+            for( size_t i = 0, j = n-1; i < n; j = i++ ) {
+                const ofVec3f& a = verts[i];
+                const ofVec3f& b = verts[j];
+                if( (a.y > py) != (b.y > py) ) {
+                    crossings.push_back( (b.x-a.x)*(py-a.y)/(b.y-a.y)+a.x );
+                }
+            }
+            std::sort( crossings.begin(), crossings.end() );
+            uint16_t* row = &labels[ (size_t)y * width ];
+            for( size_t c = 0; c + 1 < crossings.size(); c += 2 ) {
+                // centres from the first crossing up to, not including, the second //
+                int x0 = std::max( (int)ceilf( crossings[c] - 0.5f ), 0 );
+                int x1 = std::min( (int)ceilf( crossings[c+1] - 0.5f ), width );
+                if( x1 <= x0 ) continue;
+                for( int x = x0; x < x1; x++ ) {
+                    row[x] = label;
+                }
+                rowSpans[y].first = std::min( rowSpans[y].first, x0 );
+                rowSpans[y].second = std::max( rowSpans[y].second, x1 );
+            }
+        }
+    }
+    
+    for( size_t i = 0; i < labels.size(); i++ ) {
+        numPixels[ labels[i] ]++;
+    }
+}
+
+//--------------------------------------------------------------
+void ZoneMap::count( const uint8_t* amotion, size_t amotionStride, const uint8_t* apresent, size_t apresentStride,
+                     const uint16_t* adepthMm, size_t adepthStride, vector<ZoneState>& astates ) {
+    astates.resize( zones.size() );
+    // index 0 collects the pixels outside of the zones so the loop does not branch //
+    motionCounts.assign( zones.size() + 1, 0 );
+    presentCounts.assign( zones.size() + 1, 0 );
+    uint32_t* __restrict motionCount = &motionCounts[0];
+    uint32_t* __restrict presentCount = &presentCounts[0];
+    depthCounts.assign( zones.size() + 1, 0 );
+    depthSums.assign( zones.size() + 1, 0 );
+    uint32_t* __restrict depthCount = &depthCounts[0];
+    uint64_t* __restrict depthSum = &depthSums[0];
+    
+    for( int y = 0; y < height; y++ ) {
+        int x0 = rowSpans[y].first;
+        int x1 = rowSpans[y].second;
+        if( x1 <= x0 ) continue;
+        const uint16_t* row = &labels[ (size_t)y * width ];
+        const uint8_t* present = apresent + y * apresentStride;
+        if( amotion ) {
+            const uint8_t* motion = amotion + y * amotionStride;
+            for( int x = x0; x < x1; x++ ) {
+                motionCount[ row[x] ] += motion[x] != 0;
+                presentCount[ row[x] ] += present[x] != 0;
+            }
+        } else {
+            for( int x = x0; x < x1; x++ ) {
+                presentCount[ row[x] ] += present[x] != 0;
+            }
+        }
+        if( adepthMm ) {
+            const uint16_t* depth = adepthMm + y * adepthStride;
+            for( int x = x0; x < x1; x++ ) {
+                bool bReading = present[x] != 0 && depth[x] != 0;
+                depthCount[ row[x] ] += bReading;
+                depthSum[ row[x] ] += bReading ? depth[x] : 0;
+            }
+        }
+    }
+    
+    for( size_t i = 0; i < astates.size(); i++ ) {
+        astates[i].numPixels    = numPixels[i+1];
+        astates[i].numMotion    = motionCounts[i+1];
+        astates[i].numPresent   = presentCounts[i+1];
+        astates[i].meanDepthMm  = depthCounts[i+1] ? (float)depthSums[i+1] / depthCounts[i+1] : 0.f;
+    }
+}
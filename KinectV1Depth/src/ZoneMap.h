@@ -0,0 +1,83 @@
+//
+//  ZoneMap.h
+//  KinectV1Depth
+//
+//  Polygon trigger zones, rasterized once into a map of zone ids at the cv
+//  resolution. Every frame one pass over the map and the motion and depth
+//  masks counts the pixels of each zone, however many zones there are.
+//  Zones are rasterized again only when they or the resolution change.
+//
+//  zones.xml
+//  <zones>
+//      <zone>
+//          <name>door</name>
+//          <points>0.1,0.2 0.3,0.2 0.3,0.9 0.1,0.9</points>
+//      </zone>
+//  </zones>
+//  points are x,y from 0 - 1 across the processed depth image, after flipping.
+//
+
+#pragma once
+#include "ofMain.h"
+
+class Zone {
+public:
+    string name;
+    // 0 - 1 of the processed image //
+    ofPolyline polygon;
+};
+
+class ZoneState {
+public:
+    // pixels of the zone //
+    uint32_t numPixels = 0;
+    // pixels that changed since the last frame //
+    uint32_t numMotion = 0;
+    // pixels with something in front of the sensor //
+    uint32_t numPresent = 0;
+    // mean depth of the present pixels with a reading, 0 without a depth image //
+    float meanDepthMm = 0;
+    float activePct = 0.0;
+};
+
+class ZoneMap {
+public:
+    // id 0 is no zone //
+    static const size_t MAX_ZONES = 65535;
+    
+    static bool load( string afilePath, vector<Zone>& azones );
+    
+    // later zones are on top where zones overlap //
+    void setZones( const vector<Zone>& azones );
+    const vector<Zone>& getZones() const { return zones; }
+    
+    // rasterizes the zones if they or the size changed, true if it did //
+    bool update( int awidth, int aheight );
+    
+    // counts every zone into astates in one pass, amotion and adepthMm can be null. The images are //
+    // awidth x aheight of update(), nonzero mask pixels count, strides in pixels for adepthMm. astates //
+    // are resized to the zones, their activePct is kept //
+    void count( const uint8_t* amotion, size_t amotionStride, const uint8_t* apresent, size_t apresentStride,
+               const uint16_t* adepthMm, size_t adepthStride, vector<ZoneState>& astates );
+    
+    // zone index + 1 per pixel, 0 outside of every zone //
+    const vector< uint16_t >& getLabels() const { return labels; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    
+protected:
+    void rasterize();
+    
+    vector< Zone > zones;
+    bool bDirty = true;
+    int width = 0;
+    int height = 0;
+    vector< uint16_t > labels;
+    vector< uint32_t > numPixels;
+    // first and one past the last labelled column of each row, rows outside of every zone are skipped //
+    vector< std::pair<int,int> > rowSpans;
+    vector< uint32_t > motionCounts;
+    vector< uint32_t > presentCounts;
+    vector< uint32_t > depthCounts;
+    vector< uint64_t > depthSums;
+};
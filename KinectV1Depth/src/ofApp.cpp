@@ -1,7 +1,10 @@
 #include "ofApp.h"
+#include <sys/stat.h>
 
 //--------------------------------------------------------------
 void ofApp::setup() {
+    // before any other thread is started, so the profiler shows this one as main //
+    FrameProfiler::get().registerMainThread();
     ofSetFrameRate( 60 );
     
     gui.setup("Image Processing");
@@ -59,140 +62,107 @@ void ofApp::setup() {
             hitBoxes.push_back( hb );
         }
     }
+    depthProcessor.setup( hitBoxes );
+    loadZones();
+}
 
+//--------------------------------------------------------------
+void ofApp::loadZones() {
+    // only when the file changed, so it can be edited while running. The size too, //
+    // the modification time is in whole seconds //
+    struct stat st;
+    time_t tmodified = -1;
+    off_t tsize = -1;
+    if( stat( ofToDataPath( "zones.xml", true ).c_str(), &st ) == 0 ) {
+        tmodified = st.st_mtime;
+        tsize = st.st_size;
+    }
+    if( tmodified == zonesModified && tsize == zonesSize ) return;
+    zonesModified = tmodified;
+    zonesSize = tsize;
+    if( ZoneMap::load( "zones.xml", zones ) ) {
+        ofLogNotice("ofApp") << "loaded " << zones.size() << " zones";
+    }
+    depthProcessor.setZones( zones );
 }
 
 //--------------------------------------------------------------
 void ofApp::update() {
+    FrameProfiler::get().beginFrame();
+    PROFILE_SCOPE( "update" );
+    
+    if( ofGetElapsedTimef() - lastZonesCheckTime >= 1.f ) {
+        lastZonesCheckTime = ofGetElapsedTimef();
+        loadZones();
+    }
     
     bool bReceivedNewFrame = false;
+    DepthInput& input = depthProcessor.getInput();
     
     if( bUseLiveKinect ) {
+        PROFILE_SCOPE( "kinect" );
         kinect.update();
         // only perform cpu intense cv operations when new data has been received //
         if( kinect.isFrameNew() ) {
             if( nearClip != kinect.getNearClipping() || farClip != kinect.getFarClipping() ){
+                // the kinect's own 8 bit depth is only drawn for debugging //
                 kinect.setDepthClipping(nearClip, farClip);
             }
             bReceivedNewFrame = true;
-            grayPixels = kinect.getDepthPixels();
-            grayCv.setFromPixels( grayPixels );
+            // straight from the driver's buffer into the worker's input, see DepthIngest.h //
+            const ofShortPixels& rawDepth = kinect.getRawDepthPixels();
+            depthIngest.setClipping( nearClip, farClip );
+            depthIngest.process( rawDepth.getData(), rawDepth.getWidth(), rawDepth.getHeight(), bFlipX, bFlipY, input.depth, input.depthMm );
         }
     } else {
+        PROFILE_SCOPE( "video" );
         videoPlayer.update();
         if( videoPlayer.isFrameNew() ) {
             bReceivedNewFrame = true;
-            ofPixels& videoPixels = videoPlayer.getPixels();
-            // allocate the cv images to the size of the video pixels //
-            if( colorCv.getWidth() != videoPixels.getWidth() ){
-                // we aren't going to draw these cv images, so do not use a texture
-                // to help reduce overhead //
-                colorCv.setUseTexture(false);
-                colorCv.allocate(videoPixels.getWidth(), videoPixels.getHeight());
-                grayCv.setUseTexture(false);
-                grayCv.allocate(videoPixels.getWidth(), videoPixels.getHeight());
-            }
-            // the video comes in as RGB
-            colorCv.setFromPixels(videoPixels);
-            // ofxCvGrayscaleImage can be set from an ofxOpenCvColorImage
-            // converts from color to gray
-            grayCv      = colorCv;
-            //grayPixels  = grayCv.getPixels();
+            // the video comes in as RGB, converted to gray on the worker //
+            input.pixels = videoPlayer.getPixels();
         }
     }
     
     if( bReceivedNewFrame ) {
-        if( bFlipX || bFlipY ){
-            grayCv.mirror(bFlipY, bFlipX);
-        }
-        
-        prevFrame = processedCv;
-        
-        // set the cv image from the pixels we have extracted //
-//        processedCv.setFromPixels( grayPixels );
-        if( processedCv.getWidth() == 0 ) {
-            processedCv.allocate( grayCv.getWidth()/2, grayCv.getHeight()/2 );
-        }
-        // perform operations at a smaller size //
-        processedCv.scaleIntoMe( grayCv, CV_INTER_LINEAR );
-        
-        if( blurAmount > 0 ) {
-            //processedCv.blurGaussian( preBlurAmount*2+1 );
-        }
-        
-        processedCv.threshold( threshold );
-        
-        for( int i = 0; i < numDilatePasses; i++ ) {
-            processedCv.dilate();
-            if(blurAmount>0)processedCv.blurGaussian(blurAmount*2+1);
-            processedCv.erode_3x3();
-        }
-        
-        if( prevFrame.getWidth() && processedCv.getWidth() ) {
-            historyCv.absDiff( prevFrame, processedCv );
-        }
-        
-//        findContours( ofxCvGrayscaleImage&  input,
-//                     int minArea,
-//                     int maxArea,
-//                     int nConsidered,
-//                     bool bFindHoles,
-//                     bool bUseApproximation)
         if( maxSize < minSize ) {
             maxSize = minSize;
         }
-        finder.findContours( processedCv, minSize*minSize, maxSize*maxSize, 20, true, false);
-        
-        contours.clear();
-        // copy the contours and apply some smoothing //
-        vector< ofxCvBlob >& blobs = finder.blobs;
-        for( int d = 0; d < blobs.size(); d++ ) {
-            ofPolyline tempPoly;
-            tempPoly.addVertices( blobs[d].pts );
-            if( tempPoly.getPerimeter() > contourPolySpacing ) {
-                tempPoly = tempPoly.getResampledBySpacing( contourPolySpacing );
-            }
-            if( contourSmoothing > 0 ) {
-                tempPoly = tempPoly.getSmoothed( contourSmoothing );
-            }
-            contours.push_back( tempPoly );
+        DepthSettings& settings         = input.settings;
+        settings.numDilatePasses        = numDilatePasses;
+        settings.blurAmount             = blurAmount;
+        settings.threshold              = threshold;
+        settings.minSize                = minSize;
+        settings.maxSize                = maxSize;
+        settings.contourPolySpacing     = contourPolySpacing;
+        settings.contourSmoothing       = contourSmoothing;
+        settings.minPixToActivateBox    = minPixToActivateBox;
+        settings.bFlipX                 = bFlipX;
+        settings.bFlipY                 = bFlipY;
+        settings.bScreenSpace           = !bDebug;
+        settings.screenWidth            = ofGetWidth();
+        settings.screenHeight           = ofGetHeight();
+        depthProcessor.submit();
+    }
+    
+    // the newest finished frame, if there is one //
+    if( depthProcessor.update() && bDebug ) {
+        PROFILE_SCOPE( "cv textures" );
+        const DepthResult& result = depthProcessor.getResult();
+        if( result.processed.isAllocated() ) {
+            processedTexture.loadData( result.processed );
         }
-        
-        // all of the contours are relative to the width and height of the kinect depth image
-        // convert them to screen space //
-        if( !bDebug ) {
-            float xscale = (float)ofGetWidth() / processedCv.getWidth();
-            float yscale = (float)ofGetHeight() / processedCv.getHeight();
-            for( int i = 0; i < contours.size(); i++ ) {
-                // loop through all of the vertices and scale them //
-                for( int j = 0; j < contours[i].getVertices().size(); j++ ) {
-                    contours[i].getVertices()[j].x *= xscale;
-                    contours[i].getVertices()[j].y *= yscale;
-                }
-            }
-            
-            float rxscale = processedCv.getWidth() / (float)ofGetWidth();
-            float ryscale = processedCv.getHeight() / (float)ofGetHeight();
-            // check the motion history to see if one of the boxes should be hit //
-            for( int i = 0; i < hitBoxes.size(); i++ ) {
-                ofRectangle tempRect = hitBoxes[i].rectangle;
-                tempRect.x *= rxscale;
-                tempRect.width *= rxscale;
-                tempRect.y *= ryscale;
-                tempRect.height *= ryscale;
-                if (historyCv.countNonZeroInRegion( tempRect.x, tempRect.y, tempRect.width, tempRect.height ) > minPixToActivateBox*minPixToActivateBox ) {
-                    hitBoxes[i].hitPct += 0.1;
-                } else {
-                    hitBoxes[i].hitPct -= 0.01;
-                }
-                hitBoxes[i].hitPct = ofClamp(hitBoxes[i].hitPct, 0.0, 1.0 );
-            }
+        if( result.history.isAllocated() ) {
+            historyTexture.loadData( result.history );
         }
     }
 }
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+    PROFILE_SCOPE( "draw" );
+    const DepthResult& result = depthProcessor.getResult();
+    const vector< ofPolyline >& contours = result.contours;
     ofSetColor( 255 );
     if( bDebug ) {
         if( bUseLiveKinect ) {
@@ -200,20 +170,31 @@ void ofApp::draw() {
         } else {
             videoPlayer.draw( 10, 10, videoPlayer.getWidth(), videoPlayer.getHeight() );
         }
-        if( processedCv.bAllocated ) {
+        if( processedTexture.isAllocated() ) {
             ofPushMatrix(); {
                 ofTranslate( 660, 10 );
-                processedCv.draw( 0, 0 );
+                processedTexture.draw( 0, 0 );
                 ofSetColor( ofColor::pink );
                 for( int i = 0; i < contours.size(); i++ ) {
                     contours[i].draw();
                 }
+                ofSetColor( ofColor::yellow );
+                for( auto& zone : zones ) {
+                    ofPolyline outline = zone.polygon;
+                    for( auto& vert : outline.getVertices() ) {
+                        vert.x *= processedTexture.getWidth();
+                        vert.y *= processedTexture.getHeight();
+                    }
+                    outline.draw();
+                }
                 ofSetColor(255);
-                historyCv.draw( 0, processedCv.getHeight() + 20 );
+                if( historyTexture.isAllocated() ) {
+                    historyTexture.draw( 0, processedTexture.getHeight() + 20 );
+                }
             } ofPopMatrix();
         }
     } else {
-        
+        const vector< HitBox >& hitBoxes = result.hitBoxes;
         ofSetColor( 40 );
         for( int i = 0; i < contours.size(); i++ ) {
             contours[i].draw();
@@ -230,10 +211,44 @@ void ofApp::draw() {
             ofDrawRectangle( hitBoxes[i].rectangle );
             ofFill();
         }
+        
+        // the zone states match zones once the worker has picked them up //
+        const vector< ZoneState >& zoneStates = result.zones;
+        for( size_t i = 0; i < zones.size() && i < zoneStates.size(); i++ ) {
+            const vector< ofVec3f >& verts = zones[i].polygon.getVertices();
+            if( zoneStates[i].activePct > 0.0 ) {
+                ofSetColor( 30, 200, 220, 225.f * zoneStates[i].activePct );
+                ofBeginShape();
+                for( auto& vert : verts ) {
+                    ofVertex( vert.x * ofGetWidth(), vert.y * ofGetHeight() );
+                }
+                ofEndShape( true );
+            }
+            ofSetColor( 120 );
+            ofNoFill();
+            ofBeginShape();
+            for( auto& vert : verts ) {
+                ofVertex( vert.x * ofGetWidth(), vert.y * ofGetHeight() );
+            }
+            ofEndShape( true );
+            ofFill();
+        }
     }
     
     if( !bHide ){
         gui.draw();
+        if( bDebug ) {
+            DepthProcessor::Stats stats = depthProcessor.getStats();
+            stringstream ss;
+            ss << "depth frames: " << stats.numSubmitted << " processed: " << stats.numProcessed << endl;
+            ss << "  dropped inputs: " << stats.numDroppedInputs << " results: " << stats.numDroppedResults << endl;
+            ss << "  process: " << ofToString(stats.processMs, 2) << "ms" << endl;
+            ss << "  latency: " << ofToString(stats.latencyMs, 2) << "ms avg: " << ofToString(stats.latencyAvgMs, 2) << "ms max: " << ofToString(stats.latencyMaxMs, 2) << "ms";
+            ofDrawBitmapStringHighlight( ss.str(), gui.getPosition().x, gui.getPosition().y + gui.getHeight() + 20 );
+        }
+        if( FrameProfiler::isEnabled() ) {
+            FrameProfiler::get().draw( gui.getPosition().x - 360, gui.getPosition().y + 10 );
+        }
     }
 }
 
@@ -251,6 +266,24 @@ void ofApp::keyPressed(int key){
     if(key == 'l') {
         gui.loadFromFile("settings.xml");
     }
+    if( key == 'p' ) {
+        FrameProfiler::get().setEnabled( !FrameProfiler::isEnabled() );
+    }
+    if( key == 't' ) {
+        FrameProfiler::get().dump();
+    }
+    if( key == 'b' ) {
+        DepthMorphology::Settings settings;
+        settings.threshold = threshold;
+        settings.numPasses = numDilatePasses;
+        settings.blurSize  = blurAmount > 0 ? blurAmount*2+1 : 0;
+        Benchmarks::log( Benchmarks::runMorphology( settings ) );
+        Benchmarks::log( Benchmarks::runHitBoxes( 12, 8 ) );
+        Benchmarks::log( Benchmarks::runHitBoxes( 100, 100 ) );
+        Benchmarks::log( Benchmarks::runZones( 100 ) );
+        Benchmarks::log( Benchmarks::runZones( 5000 ) );
+        Benchmarks::log( Benchmarks::runDepthIngest( nearClip, farClip ) );
+    }
 }
 
 //--------------------------------------------------------------
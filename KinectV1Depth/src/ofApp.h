@@ -4,19 +4,17 @@
 #include "ofxKinect.h"
 #include "ofxOpenCv.h"
 #include "ofxGui.h"
-
-class HitBox {
-public:
-    ofRectangle rectangle;
-    float hitPct = 0.0;
-};
+#include "FrameProfiler.h"
+#include "DepthProcessor.h"
+#include "DepthIngest.h"
+#include "Benchmarks.h"
 
 class ofApp : public ofBaseApp {
 public:
     void setup();
     void update();
     void draw();
-
+    
     void keyPressed(int key);
     void keyReleased(int key);
     void mouseMoved(int x, int y );
@@ -38,6 +36,7 @@ public:
     ofParameter <int> nearClip;
     ofParameter <int> farClip;
     ofParameter <bool> bFlipX, bFlipY;
+    DepthIngest depthIngest;
     
     ofVideoPlayer videoPlayer;
     
@@ -49,21 +48,26 @@ public:
     ofParameter<int> threshold;
     ofParameter<float> minSize, maxSize;
     
-    ofPixels grayPixels;
-    ofxCvColorImage colorCv;
-    ofxCvGrayscaleImage grayCv;
-    ofxCvGrayscaleImage processedCv;
-    ofxCvGrayscaleImage prevFrame;
-    ofxCvGrayscaleImage historyCv;
-    ofxCvContourFinder finder;
+    // the cv chain runs on its own thread, see DepthProcessor.h //
+    DepthProcessor depthProcessor;
+    ofTexture processedTexture;
+    ofTexture historyTexture;
     
     ofParameter<int> contourPolySpacing;
     ofParameter<int> contourSmoothing;
     
     ofParameter<int> minPixToActivateBox;
     
-    vector< ofPolyline > contours;
+    // layout in screen space, their state is in the DepthProcessor results //
     vector< HitBox > hitBoxes;
     
+    // polygon trigger zones from zones.xml, in 0 - 1 of the processed image //
+    void loadZones();
+    vector< Zone > zones;
+    // of the zones.xml last loaded, -1 while there is none //
+    time_t zonesModified = -1;
+    off_t zonesSize = -1;
+    float lastZonesCheckTime = 0;
+    
     int incBlobId = 1;
 };
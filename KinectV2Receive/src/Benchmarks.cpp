@@ -0,0 +1,368 @@
+//
+//  Benchmarks.cpp
+//  KinectV2Receive
+//
+
+#include "Benchmarks.h"
+#include "SkeletonOscRouter.h"
+#include "ParticleRenderer.h"
+#include "SkeletonTrackCodec.h"
+#include "SkeletonFrameRelay.h"
+#include "SkeletonTable.h"
+
+//--------------------------------------------------------------
+static vector<string> splitAddress( const string &s, char delim ) {
+    stringstream ss(s);
+    string item;
+    vector<string> tokens;
+    while (getline(ss, item, delim)) {
+        tokens.push_back(item);
+    }
+    return tokens;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runOscRouting( const SkeletonRecording& arecording, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    
+    // rebuild the messages as they come off the wire //
+    vector< string > addresses;
+    vector< string > states;
+    for( size_t i = 0; i < arecording.getNumRecords(); i++ ) {
+        const SkeletonRecord& rec = arecording.getRecords()[i];
+        addresses.push_back( "/bodies/"+arecording.getBodyId(rec.body)+"/joints/"+Skeleton::getNameForIndex((Skeleton::JointIndex)rec.joint) );
+        states.push_back( Skeleton::getNameForTrackingState((Skeleton::TrackingState)rec.state) );
+    }
+    if( addresses.empty() ) return results;
+    
+    // keeps the compiler from dropping the work //
+    uint64_t checksum = 0;
+    
+    BenchmarkResult splitResult;
+    splitResult.name = "osc routing, split";
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        for( size_t i = 0; i < addresses.size(); i++ ) {
+            // the parsing done by ofApp::parseMessage before the router //
+            string address = addresses[i];
+            if( address.size() > 0 && address[0] == '/' ) {
+                address = address.substr( 1, address.size()-1 );
+            }
+            vector< string > parts = splitAddress( address, '/' );
+            if( parts.size() >= 4 && parts[2] == "joints" ) {
+                string status = states[i];
+                bool bSeen = (status != "NotTracked" && status != "Unknown");
+                checksum += parts[1].size() + Skeleton::getIndexForName( parts[3] ) + bSeen;
+            }
+        }
+    }
+    splitResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    splitResult.count = (uint64_t)anumPasses * addresses.size();
+    results.push_back( splitResult );
+    
+    BenchmarkResult routerResult;
+    routerResult.name = "osc routing, router";
+    SkeletonOscRouter router;
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        for( size_t i = 0; i < addresses.size(); i++ ) {
+            SkeletonOscRouter::Route troute = router.route( addresses[i] );
+            if( troute.type == SkeletonOscRouter::ROUTE_JOINT ) {
+                bool bSeen = Skeleton::isSeen( SkeletonOscRouter::decodeTrackingState(states[i]) );
+                checksum += router.getBodyId( troute.body ).size() + troute.joint + bSeen;
+            }
+        }
+    }
+    routerResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    routerResult.count = (uint64_t)anumPasses * addresses.size();
+    results.push_back( routerResult );
+    
+    ofLogVerbose("Benchmarks") << "checksum " << checksum;
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runTrackCodec( const SkeletonRecording& arecording, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    size_t numRecords = arecording.getNumRecords();
+    if( !numRecords ) return results;
+    
+    BenchmarkResult encodeResult;
+    encodeResult.name = "track encode";
+    vector< char > encoded;
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        SkeletonTrackCodec::encode( arecording.getRecords(), numRecords, arecording.getBodyIds(), encoded );
+    }
+    encodeResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    encodeResult.count = (uint64_t)anumPasses * numRecords;
+    results.push_back( encodeResult );
+    
+    BenchmarkResult decodeResult;
+    decodeResult.name = "track decode";
+    SkeletonTrackDecoder decoder;
+    vector< SkeletonRecord > decoded;
+    if( !decoder.open( &encoded[0], encoded.size() ) ) return results;
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        decoder.decodeAll( decoded );
+    }
+    decodeResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    decodeResult.count = (uint64_t)anumPasses * numRecords;
+    results.push_back( decodeResult );
+    
+    float maxError = 0;
+    for( size_t i = 0; i < decoded.size(); i++ ) {
+        const SkeletonRecord& rec = arecording.getRecords()[i];
+        maxError = std::max( maxError, ofVec3f( rec.x, rec.y, rec.z ).distance( ofVec3f( decoded[i].x, decoded[i].y, decoded[i].z ) ) );
+    }
+    ofLogNotice("Benchmarks") << "track codec: " << ofToString( (double)encoded.size() / numRecords, 2 ) << " bytes per record, "
+        << ofToString( (double)(numRecords * sizeof(SkeletonRecord)) / encoded.size(), 1 ) << "x smaller than .kskel, max error " << ofToString( maxError * 1000.f, 3 ) << "mm";
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runFrameRelay( const SkeletonRecording& arecording, int aport ) {
+    vector< BenchmarkResult > results;
+    size_t numRecords = arecording.getNumRecords();
+    if( !numRecords ) return results;
+    
+    // the receiving end, as a renderer would run it, anything that does not decode ends it //
+    UdpSocket receiveSocket;
+    try {
+        receiveSocket.Bind( IpEndpointName( IpEndpointName::ANY_ADDRESS, aport ) );
+    } catch( std::exception& e ) {
+        ofLogError("Benchmarks") << "frame relay: could not listen on " << aport << ", " << e.what();
+        return results;
+    }
+    vector< SkeletonFrameRelay::Frame > received;
+    std::thread receiveThread( [&]() {
+        vector< char > buffer( SkeletonFrameRelay::MAX_PACKET_SIZE );
+        IpEndpointName from;
+        SkeletonFrameRelay::Frame frame;
+        for( ;; ) {
+            size_t tsize = receiveSocket.ReceiveFrom( from, &buffer[0], buffer.size() );
+            if( !SkeletonFrameRelay::decode( &buffer[0], tsize, frame ) ) break;
+            received.push_back( frame );
+        }
+    });
+    
+    SkeletonFrameRelay relay;
+    relay.addDestination( "127.0.0.1", aport );
+    relay.start();
+    
+    // assembled at 30 fps the way ofApp does, published when a body has a new frame //
+    BenchmarkResult publishResult;
+    publishResult.name = "frame relay publish";
+    SkeletonTable table;
+    vector< SkeletonFrameRelay::Frame > published;
+    float frameTime = 1.f / 30.f;
+    size_t next = 0;
+    for( float t = 0; next < numRecords; t += frameTime ) {
+        for( ; next < numRecords && arecording.getRecords()[next].time <= t; next++ ) {
+            const SkeletonRecord& rec = arecording.getRecords()[next];
+            table.get( table.acquire( SkeletonTable::makeKey(rec.sensor, rec.body), t ) )->addJointSample( (Skeleton::JointIndex)rec.joint, ofVec3f(rec.x, rec.y, rec.z), (Skeleton::TrackingState)rec.state, t );
+        }
+        table.reapExpired( t );
+        
+        SkeletonFrameRelay::Frame expected;
+        for( size_t i = 0; i < table.size(); i++ ) {
+            if( !table.getSkeleton(i).getNumFrames() ) continue;
+            expected.keys.push_back( table.getKey(i) );
+            expected.bodies.push_back( table.getSkeleton(i).getFrame() );
+        }
+        
+        uint64_t numPublished = relay.getNumPublished();
+        uint64_t startMicros = ofGetElapsedTimeMicros();
+        relay.publish( table, t );
+        publishResult.seconds += (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+        publishResult.count++;
+        if( relay.getNumPublished() != numPublished ) {
+            published.push_back( expected );
+        }
+        for( size_t i = 0; i < table.size(); i++ ) {
+            table.getSkeleton(i).clearNewFrame();
+        }
+        // faster than real time, but not faster than the socket buffer empties //
+        ofSleepMillis( 1 );
+    }
+    results.push_back( publishResult );
+    
+    for( int i = 0; i < 1000 && relay.getStats()[0].queueDepth > 0; i++ ) {
+        ofSleepMillis( 1 );
+    }
+    SkeletonFrameRelay::Stats stats = relay.getStats()[0];
+    relay.close();
+    // a few times, in case one is lost //
+    UdpTransmitSocket stopSocket( IpEndpointName( "127.0.0.1", aport ) );
+    for( int i = 0; i < 3; i++ ) {
+        stopSocket.Send( "stop", 4 );
+    }
+    receiveThread.join();
+    
+    uint64_t numMismatched = 0;
+    float maxError = 0;
+    for( auto& frame : received ) {
+        if( frame.sequence >= published.size() ) {
+            numMismatched++;
+            continue;
+        }
+        const SkeletonFrameRelay::Frame& expected = published[ frame.sequence ];
+        if( frame.keys != expected.keys ) {
+            numMismatched++;
+            continue;
+        }
+        for( size_t b = 0; b < frame.bodies.size(); b++ ) {
+            for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+                maxError = std::max( maxError, frame.bodies[b].positions[j].distance( expected.bodies[b].positions[j] ) );
+                if( frame.bodies[b].states[j] != expected.bodies[b].states[j] ) numMismatched++;
+            }
+        }
+    }
+    
+    double bytesPerPacket = stats.numSent ? (double)stats.numBytes / stats.numSent : 0;
+    ofLogNotice("Benchmarks") << "frame relay: " << published.size() << " frames published, " << stats.numSent << " sent, " << received.size() << " received, "
+        << stats.numDropped << " dropped, " << numMismatched << " mismatched, max error " << ofToString( maxError, 3 ) << "mm";
+    ofLogNotice("Benchmarks") << "frame relay: " << ofToString( bytesPerPacket, 1 ) << " bytes per packet, "
+        << ofToString( (double)numRecords / std::max<size_t>( published.size(), 1 ), 1 ) << "x fewer packets than the joint messages";
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runParticleBuild( size_t anumParticles, int anumPasses ) {
+    vector< BenchmarkResult > results;
+    if( !anumParticles ) return results;
+    
+    ParticleSystem tparticles;
+    tparticles.allocate( anumParticles );
+    tparticles.setMaxParticles( anumParticles );
+    for( size_t i = 0; i < anumParticles; i++ ) {
+        tparticles.spawn( ofVec3f( ofRandom(-1000, 1000), ofRandom(-1000, 1000), ofRandom(-1000, 1000) ), ofVec3f(), ofRandom( 14, 26 ) );
+    }
+    
+    BenchmarkResult instanceResult;
+    instanceResult.name = "particle instance data";
+    vector< float > instanceData( anumParticles * ParticleRenderer::INSTANCE_STRIDE );
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        ParticleRenderer::buildInstanceData( tparticles, &instanceData[0] );
+    }
+    instanceResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    instanceResult.count = (uint64_t)anumPasses * anumParticles;
+    results.push_back( instanceResult );
+    
+    BenchmarkResult meshResult;
+    meshResult.name = "particle merged mesh";
+    ofMesh sphere = ofMesh::icosphere( 1, 1 );
+    ofMesh merged;
+    startMicros = ofGetElapsedTimeMicros();
+    for( int pass = 0; pass < anumPasses; pass++ ) {
+        ParticleRenderer::buildMergedMesh( tparticles, sphere, merged );
+    }
+    meshResult.seconds = (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    meshResult.count = (uint64_t)anumPasses * anumParticles;
+    results.push_back( meshResult );
+    
+    ofLogVerbose("Benchmarks") << "checksum " << instanceData[0] + (merged.getNumVertices() ? merged.getVertices()[0].x : 0.f);
+    return results;
+}
+
+//--------------------------------------------------------------
+vector< BenchmarkResult > Benchmarks::runSkeletonFilter( const SkeletonFilter& afilter, int anumBodies, int anumFrames ) {
+    vector< BenchmarkResult > results;
+    if( anumBodies < 1 || anumFrames < 1 ) return results;
+    
+    SkeletonFilter tfilter = afilter;
+    tfilter.clear();
+    // a jittery wave per joint //
+    vector< Skeleton::BodyFrame > frames( anumBodies );
+    for( auto& frame : frames ) {
+        for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+            frame.states[j] = j % 5 ? Skeleton::TRACKING_TRACKED : Skeleton::TRACKING_INFERRED;
+        }
+    }
+    
+    BenchmarkResult result;
+    result.name = "skeleton filter, per body per frame";
+    double filterSeconds = 0;
+    for( int f = 0; f < anumFrames; f++ ) {
+        for( int b = 0; b < anumBodies; b++ ) {
+            Skeleton::BodyFrame& frame = frames[b];
+            frame.time = f / 30.f;
+            for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+                frame.positions[j].set( sin(frame.time + j) * 500 + ofRandom(-5, 5), j * 40 + ofRandom(-5, 5), 2000 + b * 300 + ofRandom(-5, 5) );
+            }
+        }
+        uint64_t startMicros = ofGetElapsedTimeMicros();
+        for( int b = 0; b < anumBodies; b++ ) {
+            tfilter.filter( b, 0, frames[b] );
+        }
+        filterSeconds += (ofGetElapsedTimeMicros() - startMicros) / 1000000.0;
+    }
+    result.seconds = filterSeconds;
+    result.count = (uint64_t)anumBodies * anumFrames;
+    results.push_back( result );
+    return results;
+}
+
+//--------------------------------------------------------------
+float Benchmarks::measureJitter( const SkeletonRecording& arecording, const SkeletonFilter* afilter ) {
+    SkeletonFilter tfilter;
+    if( afilter ) {
+        tfilter = *afilter;
+        tfilter.clear();
+    }
+    
+    // assembled the same way as live, the last two output frames kept per body //
+    vector< Skeleton > skeletons( arecording.getNumBodyIds() );
+    vector< uint64_t > numFrames( skeletons.size(), 0 );
+    vector< array<Skeleton::BodyFrame, 2> > history( skeletons.size() );
+    for( auto& skeleton : skeletons ) {
+        skeleton.build( 0 );
+    }
+    
+    double sum = 0;
+    uint64_t count = 0;
+    for( size_t i = 0; i < arecording.getNumRecords(); i++ ) {
+        const SkeletonRecord& rec = arecording.getRecords()[i];
+        if( rec.body >= skeletons.size() ) continue;
+        Skeleton& skeleton = skeletons[rec.body];
+        uint64_t before = skeleton.getNumFrames();
+        skeleton.addJointSample( (Skeleton::JointIndex)rec.joint, ofVec3f(rec.x, rec.y, rec.z), (Skeleton::TrackingState)rec.state, rec.time );
+        if( skeleton.getNumFrames() == before ) continue;
+        
+        Skeleton::BodyFrame frame = skeleton.getFrame();
+        if( afilter ) {
+            tfilter.filter( rec.body, 0, frame );
+        }
+        uint64_t n = numFrames[rec.body]++;
+        array<Skeleton::BodyFrame, 2>& hist = history[rec.body];
+        if( n >= 2 ) {
+            for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+                if( frame.states[j] != Skeleton::TRACKING_TRACKED ) continue;
+                ofVec3f accel = frame.positions[j] - hist[1].positions[j] * 2.f + hist[0].positions[j];
+                sum += accel.length();
+                count++;
+            }
+        }
+        hist[0] = hist[1];
+        hist[1] = frame;
+    }
+    return count ? (float)(sum / count) : 0.f;
+}
+
+//--------------------------------------------------------------
+void Benchmarks::logFilterJitter( const SkeletonRecording& arecording, const SkeletonFilter& afilter ) {
+    float raw = measureJitter( arecording, nullptr );
+    float filtered = measureJitter( arecording, &afilter );
+    float reduction = raw > 0 ? (1.f - filtered / raw) * 100.f : 0.f;
+    ofLogNotice("Benchmarks") << "joint jitter raw: " << raw << "mm filtered: " << filtered << "mm (" << ofToString(reduction, 1) << "% less)";
+}
+
+//--------------------------------------------------------------
+void Benchmarks::log( const vector<BenchmarkResult>& aresults ) {
+    for( auto& result : aresults ) {
+        double nsEach = result.count ? result.seconds * 1000000000.0 / result.count : 0;
+        ofLogNotice("Benchmarks") << result.name << ": " << (uint64_t)result.getPerSecond() << " /sec, " << ofToString(nsEach, 1) << "ns each (" << result.count << " in " << result.seconds << "s)";
+    }
+}
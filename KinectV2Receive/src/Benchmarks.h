@@ -0,0 +1,44 @@
+//
+//  Benchmarks.h
+//  KinectV2Receive
+//
+//  Micro benchmarks for the receive pipeline, results are logged.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SkeletonRecording.h"
+#include "SkeletonFilter.h"
+
+class BenchmarkResult {
+public:
+    string name;
+    uint64_t count = 0;
+    double seconds = 0;
+    
+    double getPerSecond() const { return seconds > 0 ? (double)count / seconds : 0; }
+};
+
+class Benchmarks {
+public:
+    // routes the joint messages of arecording with the old split based parsing and the SkeletonOscRouter //
+    static vector< BenchmarkResult > runOscRouting( const SkeletonRecording& arecording, int anumPasses = 20 );
+    
+    // compresses and decompresses arecording with SkeletonTrackCodec, counted per record //
+    static vector< BenchmarkResult > runTrackCodec( const SkeletonRecording& arecording, int anumPasses = 20 );
+    
+    // replays arecording through a SkeletonFrameRelay to a receiver on loopback aport, checks every packet that arrives //
+    static vector< BenchmarkResult > runFrameRelay( const SkeletonRecording& arecording, int aport = 12599 );
+    
+    // fills the particle instance buffer and the merged mesh fallback, no gl needed //
+    static vector< BenchmarkResult > runParticleBuild( size_t anumParticles, int anumPasses = 20 );
+    
+    // filters anumFrames frames of anumBodies moving bodies, counted per body per frame //
+    static vector< BenchmarkResult > runSkeletonFilter( const SkeletonFilter& afilter, int anumBodies = 6, int anumFrames = 2000 );
+    // mean second difference of the tracked joints in mm, a measure of jitter //
+    static float measureJitter( const SkeletonRecording& arecording, const SkeletonFilter* afilter );
+    // jitter of arecording before and after afilter //
+    static void logFilterJitter( const SkeletonRecording& arecording, const SkeletonFilter& afilter );
+    
+    static void log( const vector<BenchmarkResult>& aresults );
+};
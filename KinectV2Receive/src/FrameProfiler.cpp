@@ -0,0 +1,229 @@
+//
+//  FrameProfiler.cpp
+//  KinectV2Receive
+//
+
+#include "FrameProfiler.h"
+
+atomic< bool > FrameProfiler::bEnabled{false};
+
+//--------------------------------------------------------------
+FrameProfiler& FrameProfiler::get() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+//--------------------------------------------------------------
+uint64_t FrameProfiler::now() {
+    // relative to the first call, so a start time is never 0 //
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now() - std::chrono::nanoseconds(1);
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now() - epoch ).count();
+}
+
+//--------------------------------------------------------------
+FrameProfiler::FrameProfiler() {
+    threads.push_back( unique_ptr<ThreadBuffer>( new ThreadBuffer() ) );
+    threads[0]->name = "main";
+}
+
+//--------------------------------------------------------------
+FrameProfiler::ThreadBufferOwner::~ThreadBufferOwner() {
+    if( buffer ) FrameProfiler::get().retireThreadBuffer( buffer );
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::registerMainThread() {
+    std::unique_lock<std::mutex> lck( threadsMutex );
+    mainThreadId = std::this_thread::get_id();
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::setEnabled( bool ab ) {
+    now();
+    bEnabled.store( ab, std::memory_order_relaxed );
+}
+
+//--------------------------------------------------------------
+FrameProfiler::ThreadBuffer* FrameProfiler::getThreadBuffer() {
+    static thread_local ThreadBufferOwner owner;
+    if( !owner.buffer ) {
+        // once per thread //
+        std::unique_lock<std::mutex> lck( threadsMutex );
+        if( std::this_thread::get_id() == mainThreadId ) {
+            // the main thread's is never handed to another thread //
+            owner.buffer = threads[0].get();
+            return owner.buffer;
+        }
+        for( size_t i = 1; i < threads.size(); i++ ) {
+            if( threads[i]->bRetired ) {
+                // events of the thread before stay under its thread id //
+                owner.buffer = threads[i].get();
+                owner.buffer->bRetired = false;
+                break;
+            }
+        }
+        if( !owner.buffer ) {
+            threads.push_back( unique_ptr<ThreadBuffer>( new ThreadBuffer() ) );
+            owner.buffer = threads.back().get();
+            owner.buffer->thread = (uint32_t)threads.size() - 1;
+        }
+        owner.buffer->name = "thread "+ofToString(owner.buffer->thread);
+    }
+    return owner.buffer;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::retireThreadBuffer( ThreadBuffer* abuffer ) {
+    std::unique_lock<std::mutex> lck( threadsMutex );
+    abuffer->bRetired = true;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::record( const char* aname, uint64_t astartNanos, uint64_t aendNanos ) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    if( !buffer->ring.capacity() ) {
+        // beginFrame() may be draining the other rings //
+        std::unique_lock<std::mutex> lck( threadsMutex );
+        buffer->ring.allocate( RING_SIZE );
+    }
+    ProfileEvent tevent;
+    tevent.name          = aname;
+    tevent.startNanos    = astartNanos;
+    tevent.durationNanos = aendNanos - astartNanos;
+    tevent.thread        = buffer->thread;
+    if( !buffer->ring.push( tevent ) ) {
+        buffer->numDropped++;
+    }
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::setThreadName( const string& aname ) {
+    ThreadBuffer* buffer = getThreadBuffer();
+    std::unique_lock<std::mutex> lck( threadsMutex );
+    buffer->name = aname;
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::beginFrame() {
+    drained.clear();
+    {
+        std::unique_lock<std::mutex> lck( threadsMutex );
+        numDropped = 0;
+        for( auto& buffer : threads ) {
+            ProfileEvent tevent;
+            if( !buffer->ring.capacity() ) continue;
+            while( buffer->ring.pop( tevent ) ) {
+                drained.push_back( tevent );
+            }
+            numDropped += buffer->numDropped;
+        }
+    }
+    
+    for( auto& tevent : drained ) {
+        addToHistory( tevent );
+        Stat* tstat = nullptr;
+        for( auto& s : stats ) {
+            if( s.name == tevent.name && s.thread == tevent.thread ) {
+                tstat = &s;
+                break;
+            }
+        }
+        if( !tstat ) {
+            stats.push_back( Stat() );
+            tstat = &stats.back();
+            tstat->name = tevent.name;
+            tstat->thread = tevent.thread;
+        }
+        tstat->nanosThisFrame += tevent.durationNanos;
+        tstat->numThisFrame++;
+    }
+    
+    for( auto& s : stats ) {
+        s.lastMs        = s.nanosThisFrame / 1000000.f;
+        s.numLastFrame  = s.numThisFrame;
+        s.avgMs         = s.avgMs * 0.95f + s.lastMs * 0.05f;
+        // decays so a single spike fades out over a few seconds //
+        s.maxMs         = std::max( s.lastMs, s.maxMs * 0.995f );
+        s.nanosThisFrame = 0;
+        s.numThisFrame  = 0;
+    }
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::addToHistory( const ProfileEvent& aevent ) {
+    if( history.size() < MAX_HISTORY ) {
+        history.push_back( aevent );
+    } else {
+        history[ historyStart ] = aevent;
+        historyStart = (historyStart + 1) % MAX_HISTORY;
+    }
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::draw( float ax, float ay ) const {
+    stringstream ss;
+    ss << "profiler (ms)      last    avg    max" << endl;
+    for( auto& s : stats ) {
+        string label = s.name;
+        if( s.thread ) label += " ["+ofToString(s.thread)+"]";
+        if( label.size() < 16 ) label.append( 16 - label.size(), ' ' );
+        ss << label << " " << ofToString(s.lastMs, 2, 6, ' ') << " " << ofToString(s.avgMs, 2, 6, ' ') << " " << ofToString(s.maxMs, 2, 6, ' ');
+        if( s.numLastFrame > 1 ) ss << " x" << s.numLastFrame;
+        ss << endl;
+    }
+    if( numDropped ) ss << "dropped events: " << numDropped << endl;
+    ss << "'p' profiler off, 't' dump trace";
+    ofDrawBitmapStringHighlight( ss.str(), ax, ay );
+}
+
+//--------------------------------------------------------------
+bool FrameProfiler::dumpTrace( string afilePath ) const {
+    ofstream fout( ofToDataPath(afilePath, true).c_str() );
+    if( !fout ) {
+        ofLogError("FrameProfiler::dumpTrace") << "could not open " << afilePath;
+        return false;
+    }
+    fout << "{\"traceEvents\":[" << endl;
+    bool bFirst = true;
+    {
+        std::unique_lock<std::mutex> lck( threadsMutex );
+        for( auto& buffer : threads ) {
+            fout << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread << ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+            bFirst = false;
+        }
+    }
+    for( size_t i = 0; i < history.size(); i++ ) {
+        const ProfileEvent& tevent = history[ (historyStart + i) % history.size() ];
+        fout << (bFirst ? "" : ",\n") << "{\"name\":\"" << tevent.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tevent.thread;
+        fout << ",\"ts\":" << ofToString( tevent.startNanos / 1000.0, 3 ) << ",\"dur\":" << ofToString( tevent.durationNanos / 1000.0, 3 ) << "}";
+        bFirst = false;
+    }
+    fout << "\n]}" << endl;
+    return fout.good();
+}
+
+//--------------------------------------------------------------
+bool FrameProfiler::dumpCsv( string afilePath ) const {
+    ofstream fout( ofToDataPath(afilePath, true).c_str() );
+    if( !fout ) {
+        ofLogError("FrameProfiler::dumpCsv") << "could not open " << afilePath;
+        return false;
+    }
+    fout << "name,thread,start_us,duration_us" << endl;
+    for( size_t i = 0; i < history.size(); i++ ) {
+        const ProfileEvent& tevent = history[ (historyStart + i) % history.size() ];
+        fout << tevent.name << "," << tevent.thread << "," << ofToString( tevent.startNanos / 1000.0, 3 ) << "," << ofToString( tevent.durationNanos / 1000.0, 3 ) << endl;
+    }
+    return fout.good();
+}
+
+//--------------------------------------------------------------
+void FrameProfiler::dump( string adirectory ) const {
+    if( !ofDirectory::doesDirectoryExist( adirectory ) ) {
+        ofDirectory::createDirectory( adirectory );
+    }
+    string base = ofFilePath::join( adirectory, ofGetTimestampString() );
+    if( dumpTrace( base+".json" ) && dumpCsv( base+".csv" ) ) {
+        ofLogNotice("FrameProfiler") << "wrote " << history.size() << " events to " << base << ".json and .csv";
+    }
+}
@@ -0,0 +1,92 @@
+//
+//  ParallelFor.cpp
+//  KinectV2Receive
+//
+
+#include "ParallelFor.h"
+
+//--------------------------------------------------------------
+ParallelFor::~ParallelFor() {
+    close();
+}
+
+//--------------------------------------------------------------
+void ParallelFor::setup( int anumThreads ) {
+    close();
+    if( anumThreads <= 0 ) {
+        anumThreads = std::max( 1u, std::thread::hardware_concurrency() );
+    }
+    bExit = false;
+    for( int i = 1; i < anumThreads; i++ ) {
+        workers.push_back( std::thread( &ParallelFor::workerLoop, this, i ) );
+    }
+}
+
+//--------------------------------------------------------------
+void ParallelFor::close() {
+    {
+        std::unique_lock<std::mutex> lck( mutex );
+        bExit = true;
+        startCondition.notify_all();
+    }
+    for( auto& worker : workers ) {
+        worker.join();
+    }
+    workers.clear();
+}
+
+//--------------------------------------------------------------
+void ParallelFor::run( size_t acount, const function< void(size_t, size_t) >& afunc ) {
+    int numThreads = getNumThreads();
+    if( numThreads == 1 || acount < (size_t)numThreads ) {
+        afunc( 0, acount );
+        return;
+    }
+    
+    {
+        std::unique_lock<std::mutex> lck( mutex );
+        job         = &afunc;
+        jobCount    = acount;
+        numPending  = numThreads-1;
+        generation++;
+        startCondition.notify_all();
+    }
+    
+    afunc( 0, acount / numThreads );
+    
+    std::unique_lock<std::mutex> lck( mutex );
+    doneCondition.wait( lck, [this]() { return numPending == 0; } );
+    job = nullptr;
+}
+
+//--------------------------------------------------------------
+void ParallelFor::workerLoop( int aindex ) {
+    // a job run before a setup() again is not this worker's to do //
+    uint64_t lastGeneration = 0;
+    {
+        std::unique_lock<std::mutex> lck( mutex );
+        lastGeneration = generation;
+    }
+    while( true ) {
+        const function< void(size_t, size_t) >* tjob = nullptr;
+        size_t tcount = 0;
+        {
+            std::unique_lock<std::mutex> lck( mutex );
+            startCondition.wait( lck, [&]() { return bExit || generation != lastGeneration; } );
+            if( bExit ) return;
+            lastGeneration = generation;
+            tjob = job;
+            tcount = jobCount;
+        }
+        
+        int numThreads = getNumThreads();
+        size_t begin = tcount * aindex / numThreads;
+        size_t end = tcount * (aindex+1) / numThreads;
+        (*tjob)( begin, end );
+        
+        std::unique_lock<std::mutex> lck( mutex );
+        if( --numPending == 0 ) {
+            doneCondition.notify_one();
+        }
+    }
+}
@@ -0,0 +1,37 @@
+//
+//  ParallelFor.h
+//  KinectV2Receive
+//
+//  Splits a loop over persistent worker threads. The calling thread runs the
+//  first range itself and run() returns once every range is done.
+//
+
+#pragma once
+#include "ofMain.h"
+
+class ParallelFor {
+public:
+    ~ParallelFor();
+    
+    // 0 uses one thread per core //
+    void setup( int anumThreads = 0 );
+    void close();
+    int getNumThreads() const { return (int)workers.size() + 1; }
+    
+    // calls afunc( begin, end ) for one range of [0, acount) per thread //
+    void run( size_t acount, const function< void(size_t, size_t) >& afunc );
+    
+protected:
+    void workerLoop( int aindex );
+    
+    vector< std::thread > workers;
+    std::mutex mutex;
+    std::condition_variable startCondition;
+    std::condition_variable doneCondition;
+    
+    const function< void(size_t, size_t) >* job = nullptr;
+    size_t jobCount = 0;
+    uint64_t generation = 0;
+    int numPending = 0;
+    bool bExit = false;
+};
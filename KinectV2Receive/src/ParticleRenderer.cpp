@@ -0,0 +1,131 @@
+//
+//  ParticleRenderer.cpp
+//  KinectV2Receive
+//
+
+#include "ParticleRenderer.h"
+
+static const string instancedVertexShader = R"(
+#version 150
+uniform mat4 modelViewProjectionMatrix;
+in vec4 position;
+in vec4 instance;
+void main() {
+    gl_Position = modelViewProjectionMatrix * vec4( position.xyz * instance.w + instance.xyz, 1.0 );
+}
+)";
+
+static const string instancedFragmentShader = R"(
+#version 150
+uniform vec4 globalColor;
+out vec4 outputColor;
+void main() {
+    outputColor = globalColor;
+}
+)";
+
+//--------------------------------------------------------------
+void ParticleRenderer::setup( size_t acapacity ) {
+    capacity = acapacity;
+    numInstances = 0;
+    // unit sphere, scaled and moved per particle //
+    sphereMesh = ofMesh::icosphere( 1, 1 );
+    instanceData.assign( capacity * INSTANCE_STRIDE, 0.f );
+    
+    bInstanced = false;
+    if( ofIsGLProgrammableRenderer() ) {
+        shader.setupShaderFromSource( GL_VERTEX_SHADER, instancedVertexShader );
+        shader.setupShaderFromSource( GL_FRAGMENT_SHADER, instancedFragmentShader );
+        shader.bindDefaults();
+        if( shader.linkProgram() ) {
+            instanceLocation = shader.getAttributeLocation( "instance" );
+        }
+        if( instanceLocation >= 0 ) {
+            sphereVbo.setMesh( sphereMesh, GL_STATIC_DRAW );
+            // allocated once at full capacity, only the used part is updated //
+            instanceBuffer.allocate( instanceData.size() * sizeof(float), GL_DYNAMIC_DRAW );
+            sphereVbo.setAttributeBuffer( instanceLocation, instanceBuffer, INSTANCE_STRIDE, INSTANCE_STRIDE * sizeof(float) );
+            sphereVbo.setAttributeDivisor( instanceLocation, 1 );
+            bInstanced = true;
+        }
+    }
+    if( !bInstanced ) {
+        ofLogNotice("ParticleRenderer") << "instancing not available, drawing particles as one merged mesh";
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleRenderer::update( const ParticleSystem& asystem ) {
+    numInstances = std::min( asystem.getNumParticles(), capacity );
+    if( bInstanced ) {
+        buildInstanceData( asystem, &instanceData[0] );
+        if( numInstances ) {
+            instanceBuffer.updateData( 0, numInstances * INSTANCE_STRIDE * sizeof(float), &instanceData[0] );
+        }
+    } else {
+        buildMergedMesh( asystem, sphereMesh, mergedMesh );
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleRenderer::draw() {
+    if( !numInstances ) return;
+    if( bInstanced ) {
+        ofFloatColor color = ofGetStyle().color;
+        shader.begin();
+        shader.setUniform4f( "globalColor", color.r, color.g, color.b, color.a );
+        sphereVbo.drawElementsInstanced( GL_TRIANGLES, (int)sphereMesh.getNumIndices(), (int)numInstances );
+        shader.end();
+    } else {
+        mergedMesh.draw();
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleRenderer::buildInstanceData( const ParticleSystem& asystem, float* aout ) {
+    const float* px = asystem.getPositionsX();
+    const float* py = asystem.getPositionsY();
+    const float* pz = asystem.getPositionsZ();
+    const float* sizes = asystem.getSizes();
+    size_t num = asystem.getNumParticles();
+    for( size_t i = 0; i < num; i++ ) {
+        float* inst = aout + i * INSTANCE_STRIDE;
+        inst[0] = px[i];
+        inst[1] = py[i];
+        inst[2] = pz[i];
+        inst[3] = sizes[i];
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleRenderer::buildMergedMesh( const ParticleSystem& asystem, const ofMesh& asphere, ofMesh& aout ) {
+    const vector< ofVec3f >& sphereVerts = asphere.getVertices();
+    const vector< ofIndexType >& sphereIndices = asphere.getIndices();
+    size_t numVerts = sphereVerts.size();
+    size_t numIndices = sphereIndices.size();
+    size_t num = asystem.getNumParticles();
+    
+    aout.setMode( OF_PRIMITIVE_TRIANGLES );
+    // resized in place, the mesh keeps its memory between frames //
+    vector< ofVec3f >& verts = aout.getVertices();
+    vector< ofIndexType >& indices = aout.getIndices();
+    verts.resize( num * numVerts );
+    indices.resize( num * numIndices );
+    
+    const float* px = asystem.getPositionsX();
+    const float* py = asystem.getPositionsY();
+    const float* pz = asystem.getPositionsZ();
+    const float* sizes = asystem.getSizes();
+    for( size_t i = 0; i < num; i++ ) {
+        ofVec3f center( px[i], py[i], pz[i] );
+        ofVec3f* tverts = &verts[ i * numVerts ];
+        for( size_t v = 0; v < numVerts; v++ ) {
+            tverts[v] = sphereVerts[v] * sizes[i] + center;
+        }
+        ofIndexType offset = (ofIndexType)(i * numVerts);
+        ofIndexType* tindices = &indices[ i * numIndices ];
+        for( size_t k = 0; k < numIndices; k++ ) {
+            tindices[k] = sphereIndices[k] + offset;
+        }
+    }
+}
@@ -0,0 +1,45 @@
+//
+//  ParticleRenderer.h
+//  KinectV2Receive
+//
+//  Draws every particle of a ParticleSystem with one draw call. Per particle
+//  instance data (position and size) goes into one persistent buffer each frame
+//  and a low poly sphere is drawn instanced with it. Without the programmable
+//  renderer the spheres are merged into a single mesh instead.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ParticleSystem.h"
+
+class ParticleRenderer {
+public:
+    // floats per instance: x, y, z, size //
+    static const int INSTANCE_STRIDE = 4;
+    
+    void setup( size_t acapacity );
+    void update( const ParticleSystem& asystem );
+    void draw();
+    
+    bool isInstanced() const { return bInstanced; }
+    size_t getNumInstances() const { return numInstances; }
+    const ofMesh& getSphereMesh() const { return sphereMesh; }
+    
+    // cpu side builders, no gl needed //
+    static void buildInstanceData( const ParticleSystem& asystem, float* aout );
+    static void buildMergedMesh( const ParticleSystem& asystem, const ofMesh& asphere, ofMesh& aout );
+    
+protected:
+    bool bInstanced = false;
+    size_t capacity = 0;
+    size_t numInstances = 0;
+    
+    ofMesh sphereMesh;
+    ofVbo sphereVbo;
+    ofBufferObject instanceBuffer;
+    ofShader shader;
+    int instanceLocation = -1;
+    vector< float > instanceData;
+    
+    ofMesh mergedMesh;
+};
@@ -0,0 +1,140 @@
+//
+//  ParticleSystem.cpp
+//  KinectV2Receive
+//
+
+#include "ParticleSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define PARTICLES_USE_SSE
+#endif
+
+//--------------------------------------------------------------
+void ParticleSystem::allocate( size_t acapacity ) {
+    // round up so every array starts on an aligned boundary //
+    capacity = (acapacity + 15) & ~(size_t)15;
+    size_t arrayBytes = capacity * sizeof(float);
+    storage.reset( new char[ arrayBytes * 7 + ALIGNMENT ] );
+    
+    char* base = storage.get();
+    base += (ALIGNMENT - ((uintptr_t)base % ALIGNMENT)) % ALIGNMENT;
+    float** arrays[] = { &px, &py, &pz, &vx, &vy, &vz, &sizes };
+    for( int i = 0; i < 7; i++ ) {
+        *arrays[i] = (float*)(base + i * arrayBytes);
+    }
+    
+    maxParticles = capacity;
+    numParticles = 0;
+    retireCursor = 0;
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::setMaxParticles( size_t amax ) {
+    maxParticles = std::min( amax, capacity );
+    if( numParticles > maxParticles ) {
+        numParticles = maxParticles;
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::spawn( const ofVec3f& apos, const ofVec3f& avel, float asize ) {
+    if( maxParticles == 0 ) return;
+    size_t index;
+    if( numParticles < maxParticles ) {
+        index = numParticles++;
+    } else {
+        // full, replace the particles in ring order //
+        if( retireCursor >= numParticles ) retireCursor = 0;
+        index = retireCursor++;
+    }
+    px[index] = apos.x;
+    py[index] = apos.y;
+    pz[index] = apos.z;
+    vx[index] = avel.x;
+    vy[index] = avel.y;
+    vz[index] = avel.z;
+    sizes[index] = asize;
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::update() {
+    if( numParticles >= PARALLEL_THRESHOLD ) {
+        if( parallelFor.getNumThreads() == 1 ) {
+            parallelFor.setup();
+        }
+        // split on multiples of 4 so the simd loop stays aligned //
+        size_t numBlocks = (numParticles + 3) / 4;
+        parallelFor.run( numBlocks, [this]( size_t abegin, size_t aend ) {
+            integrate( abegin * 4, std::min( aend * 4, numParticles ) );
+        });
+    } else {
+        integrate( 0, numParticles );
+    }
+    retire();
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::integrate( size_t abegin, size_t aend ) {
+    float* __restrict tpx = px;
+    float* __restrict tpy = py;
+    float* __restrict tpz = pz;
+    float* __restrict tvx = vx;
+    float* __restrict tvy = vy;
+    float* __restrict tvz = vz;
+    float* __restrict tsize = sizes;
+    
+    size_t i = abegin;
+#ifdef PARTICLES_USE_SSE
+    __m128 vdamping = _mm_set1_ps( damping );
+    __m128 vgravity = _mm_set1_ps( gravity );
+    __m128 vshrink  = _mm_set1_ps( shrink );
+    for( ; i + 4 <= aend; i += 4 ) {
+        __m128 x = _mm_mul_ps( _mm_load_ps( tvx+i ), vdamping );
+        __m128 y = _mm_sub_ps( _mm_mul_ps( _mm_load_ps( tvy+i ), vdamping ), vgravity );
+        __m128 z = _mm_mul_ps( _mm_load_ps( tvz+i ), vdamping );
+        _mm_store_ps( tvx+i, x );
+        _mm_store_ps( tvy+i, y );
+        _mm_store_ps( tvz+i, z );
+        _mm_store_ps( tpx+i, _mm_add_ps( _mm_load_ps( tpx+i ), x ) );
+        _mm_store_ps( tpy+i, _mm_add_ps( _mm_load_ps( tpy+i ), y ) );
+        _mm_store_ps( tpz+i, _mm_add_ps( _mm_load_ps( tpz+i ), z ) );
+        _mm_store_ps( tsize+i, _mm_sub_ps( _mm_load_ps( tsize+i ), vshrink ) );
+    }
+#endif
+    // the rest, or everything on platforms the compiler vectorizes for us //
+    for( ; i < aend; i++ ) {
+        tvx[i] *= damping;
+        tvy[i] = tvy[i] * damping - gravity;
+        tvz[i] *= damping;
+        tpx[i] += tvx[i];
+        tpy[i] += tvy[i];
+        tpz[i] += tvz[i];
+        tsize[i] -= shrink;
+    }
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::copyParticle( size_t afrom, size_t ato ) {
+    px[ato] = px[afrom];
+    py[ato] = py[afrom];
+    pz[ato] = pz[afrom];
+    vx[ato] = vx[afrom];
+    vy[ato] = vy[afrom];
+    vz[ato] = vz[afrom];
+    sizes[ato] = sizes[afrom];
+}
+
+//--------------------------------------------------------------
+void ParticleSystem::retire() {
+    size_t i = 0;
+    while( i < numParticles ) {
+        if( py[i] < floorY || sizes[i] < minSize ) {
+            // swap and pop //
+            numParticles--;
+            copyParticle( numParticles, i );
+        } else {
+            i++;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+//
+//  ParticleSystem.h
+//  KinectV2Receive
+//
+//  Fixed capacity particle pool stored as structure of arrays, each array
+//  aligned for SIMD. Dead particles are removed by swapping in the last one,
+//  and once the pool is at its limit new particles replace existing ones in
+//  ring order, so nothing is ever shifted.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ParallelFor.h"
+
+class ParticleSystem {
+public:
+    static const size_t ALIGNMENT = 64;
+    // integration is split across cores above this many particles //
+    static const size_t PARALLEL_THRESHOLD = 32768;
+    
+    void allocate( size_t acapacity );
+    void setMaxParticles( size_t amax );
+    size_t getMaxParticles() const { return maxParticles; }
+    size_t getCapacity() const { return capacity; }
+    size_t getNumParticles() const { return numParticles; }
+    
+    void spawn( const ofVec3f& apos, const ofVec3f& avel, float asize );
+    // one fixed step, the same as the old per frame update //
+    void update();
+    void clear() { numParticles = 0; }
+    
+    const float* getPositionsX() const { return px; }
+    const float* getPositionsY() const { return py; }
+    const float* getPositionsZ() const { return pz; }
+    const float* getSizes() const { return sizes; }
+    ofVec3f getPosition( size_t aindex ) const { return ofVec3f( px[aindex], py[aindex], pz[aindex] ); }
+    
+    float damping = 0.94f;
+    float gravity = 0.02f;
+    float shrink = (1.f/60.f)/0.08f;
+    float floorY = -1000;
+    float minSize = 0.1f;
+    
+protected:
+    void integrate( size_t abegin, size_t aend );
+    void retire();
+    void copyParticle( size_t afrom, size_t ato );
+    
+    unique_ptr< char[] > storage;
+    float* px = nullptr;
+    float* py = nullptr;
+    float* pz = nullptr;
+    float* vx = nullptr;
+    float* vy = nullptr;
+    float* vz = nullptr;
+    float* sizes = nullptr;
+    
+    size_t capacity = 0;
+    size_t maxParticles = 0;
+    size_t numParticles = 0;
+    size_t retireCursor = 0;
+    
+    ParallelFor parallelFor;
+};
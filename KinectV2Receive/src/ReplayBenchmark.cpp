@@ -0,0 +1,260 @@
+//
+//  ReplayBenchmark.cpp
+//  KinectV2Receive
+//
+
+#include "ReplayBenchmark.h"
+#include "ofApp.h"
+#include "osc/OscOutboundPacketStream.h"
+#include "osc/OscReceivedElements.h"
+#include "ParticleRenderer.h"
+#include "SkeletonRenderer.h"
+
+#if defined(KINECT_BENCH_ALLOC_HOOK)
+//--------------------------------------------------------------
+// only in benchmark builds, every operator new of the process goes through here
+// so the benchmark can count allocations //
+static atomic< uint64_t > numAllocations{0};
+
+static void* countedAlloc( size_t asize ) {
+    numAllocations.fetch_add( 1, std::memory_order_relaxed );
+    return malloc( asize ? asize : 1 );
+}
+
+void* operator new( size_t asize ) {
+    void* p = countedAlloc( asize );
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+void* operator new[]( size_t asize ) {
+    void* p = countedAlloc( asize );
+    if( !p ) throw std::bad_alloc();
+    return p;
+}
+void* operator new( size_t asize, const std::nothrow_t& ) noexcept { return countedAlloc( asize ); }
+void* operator new[]( size_t asize, const std::nothrow_t& ) noexcept { return countedAlloc( asize ); }
+void operator delete( void* p ) noexcept { free( p ); }
+void operator delete[]( void* p ) noexcept { free( p ); }
+void operator delete( void* p, const std::nothrow_t& ) noexcept { free( p ); }
+void operator delete[]( void* p, const std::nothrow_t& ) noexcept { free( p ); }
+#if defined(__cpp_sized_deallocation)
+void operator delete( void* p, size_t ) noexcept { free( p ); }
+void operator delete[]( void* p, size_t ) noexcept { free( p ); }
+#endif
+
+bool ReplayBenchmark::hasAllocationCount() {
+    return true;
+}
+
+uint64_t ReplayBenchmark::getNumAllocations() {
+    return numAllocations.load( std::memory_order_relaxed );
+}
+#else
+//--------------------------------------------------------------
+bool ReplayBenchmark::hasAllocationCount() {
+    return false;
+}
+
+uint64_t ReplayBenchmark::getNumAllocations() {
+    return 0;
+}
+#endif
+
+//--------------------------------------------------------------
+static uint64_t nowNanos() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>( std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+//--------------------------------------------------------------
+double ReplayBenchmark::StageTimes::getPercentile( double apercent ) const {
+    if( samples.empty() ) return 0;
+    vector< double > sorted = samples;
+    size_t index = std::min( sorted.size()-1, (size_t)(apercent / 100.0 * (sorted.size()-1) + 0.5) );
+    std::nth_element( sorted.begin(), sorted.begin()+index, sorted.end() );
+    return sorted[index];
+}
+
+//--------------------------------------------------------------
+double ReplayBenchmark::StageTimes::getTotal() const {
+    double total = 0;
+    for( double s : samples ) total += s;
+    return total;
+}
+
+//--------------------------------------------------------------
+bool ReplayBenchmark::parseArgs( int argc, char* argv[], Settings& asettings ) {
+    bool bBench = false;
+    for( int i = 1; i < argc; i++ ) {
+        string arg = argv[i];
+        bool bHasValue = i+1 < argc;
+        if( arg == "--bench" ) {
+            bBench = true;
+            if( bHasValue && argv[i+1][0] != '-' ) {
+                asettings.recordingPath = argv[++i];
+            }
+        } else if( arg == "--passes" && bHasValue ) {
+            asettings.passes = std::max( 1, ofToInt( argv[++i] ) );
+        } else if( arg == "--fps" && bHasValue ) {
+            asettings.frameRate = std::max( 1.f, ofToFloat( argv[++i] ) );
+        } else if( arg == "--particles" && bHasValue ) {
+            asettings.maxParticles = (size_t)std::max( 0, ofToInt( argv[++i] ) );
+        } else if( arg == "--out" && bHasValue ) {
+            asettings.outputPath = argv[++i];
+        }
+    }
+    return bBench;
+}
+
+//--------------------------------------------------------------
+int ReplayBenchmark::run( const Settings& asettings ) {
+    string path = asettings.recordingPath;
+    if( path == "" ) {
+        path = SkeletonRecording::findNewest( "recordings" );
+    }
+    SkeletonRecording recording;
+    if( path == "" || !recording.load( path ) || !recording.getNumRecords() ) {
+        ofLogError("ReplayBenchmark") << "no recording to replay: " << path;
+        return 1;
+    }
+    
+    // every record as the packet the bridge would have sent //
+    vector< char > packets;
+    vector< size_t > packetOffsets;
+    char buffer[ 1024 ];
+    for( size_t i = 0; i < recording.getNumRecords(); i++ ) {
+        const SkeletonRecord& rec = recording.getRecords()[i];
+        string address = "/bodies/"+recording.getBodyId(rec.body)+"/joints/"+Skeleton::getNameForIndex((Skeleton::JointIndex)rec.joint);
+        osc::OutboundPacketStream p( buffer, sizeof(buffer) );
+        p << osc::BeginMessage( address.c_str() ) << rec.x << rec.y << rec.z;
+        p << Skeleton::getNameForTrackingState((Skeleton::TrackingState)rec.state).c_str() << osc::EndMessage;
+        packetOffsets.push_back( packets.size() );
+        packets.insert( packets.end(), p.Data(), p.Data() + p.Size() );
+    }
+    packetOffsets.push_back( packets.size() );
+    
+    SkeletonOscRouter router;
+    SkeletonTable skeletons;
+    SkeletonTable fusedSkeletons;
+    SkeletonFusion fusion;
+    SkeletonFilter filter;
+    ParticleSystem particles;
+    particles.allocate( std::max( asettings.maxParticles, (size_t)1 ) );
+    particles.setMaxParticles( asettings.maxParticles );
+    vector< float > instanceData( particles.getCapacity() * ParticleRenderer::INSTANCE_STRIDE );
+    SkeletonRenderer skeletonRenderer;
+    vector< SkeletonJointSample > samples;
+    
+    StageTimes stages[4];
+    stages[0].name = "decode";
+    stages[1].name = "skeletons";
+    stages[2].name = "particles";
+    stages[3].name = "drawlist";
+    
+    float frameTime = 1.f / asettings.frameRate;
+    float passDuration = recording.getDuration() + frameTime;
+    // so the harness itself does not allocate while measuring //
+    size_t expectedFrames = (size_t)asettings.passes * (size_t)(passDuration * asettings.frameRate + 2);
+    for( auto& stage : stages ) {
+        stage.samples.reserve( expectedFrames );
+    }
+    samples.reserve( 1024 );
+    size_t numRecords = recording.getNumRecords();
+    uint64_t numMessages = 0;
+    uint64_t numFrames = 0;
+    uint64_t numMalformed = 0;
+    
+    uint64_t startAllocations = getNumAllocations();
+    uint64_t startNanos = nowNanos();
+    
+    for( int pass = 0; pass < asettings.passes; pass++ ) {
+        size_t next = 0;
+        for( float t = 0; next < numRecords; t += frameTime ) {
+            float now = pass * passDuration + t;
+            
+            uint64_t t0 = nowNanos();
+            samples.clear();
+            for( ; next < numRecords && recording.getRecords()[next].time <= t; next++ ) {
+                osc::ReceivedPacket packet( &packets[ packetOffsets[next] ], (int32_t)(packetOffsets[next+1] - packetOffsets[next]) );
+                osc::ReceivedMessage msg( packet );
+                SkeletonJointSample sample;
+                SkeletonOscReceiver::DecodeResult result = SkeletonOscReceiver::decode( msg, router, sample );
+                if( result == SkeletonOscReceiver::DECODE_JOINT ) {
+                    samples.push_back( sample );
+                } else if( result == SkeletonOscReceiver::DECODE_MALFORMED ) {
+                    numMalformed++;
+                }
+                numMessages++;
+            }
+            
+            uint64_t t1 = nowNanos();
+            for( size_t i = 0; i < skeletons.size(); i++ ) skeletons.getSkeleton(i).clearNewFrame();
+            for( size_t i = 0; i < fusedSkeletons.size(); i++ ) fusedSkeletons.getSkeleton(i).clearNewFrame();
+            for( auto& sample : samples ) {
+                skeletons.get( skeletons.acquire( SkeletonTable::makeKey(sample.sensor, sample.body), now ) )->addJointSample( sample.joint, sample.pos, sample.state, now );
+            }
+            skeletons.reapExpired( now );
+            fusion.update( skeletons, fusedSkeletons );
+            fusedSkeletons.reapExpired( now );
+            filter.update( fusedSkeletons );
+            
+            uint64_t t2 = nowNanos();
+            ofApp::spawnParticles( fusedSkeletons, particles );
+            particles.update();
+            
+            uint64_t t3 = nowNanos();
+            ParticleRenderer::buildInstanceData( particles, &instanceData[0] );
+            skeletonRenderer.begin();
+            for( size_t i = 0; i < fusedSkeletons.size(); i++ ) {
+                skeletonRenderer.add( fusedSkeletons.getSkeleton(i) );
+            }
+            uint64_t t4 = nowNanos();
+            
+            stages[0].samples.push_back( (t1 - t0) / 1000.0 );
+            stages[1].samples.push_back( (t2 - t1) / 1000.0 );
+            stages[2].samples.push_back( (t3 - t2) / 1000.0 );
+            stages[3].samples.push_back( (t4 - t3) / 1000.0 );
+            numFrames++;
+        }
+    }
+    
+    double seconds = (nowNanos() - startNanos) / 1000000000.0;
+    uint64_t allocations = getNumAllocations() - startAllocations;
+    
+    stringstream ss;
+    ss << "{" << endl;
+    ss << "  \"recording\": \"" << path << "\"," << endl;
+    ss << "  \"passes\": " << asettings.passes << "," << endl;
+    ss << "  \"maxParticles\": " << asettings.maxParticles << "," << endl;
+    ss << "  \"seconds\": " << seconds << "," << endl;
+    ss << "  \"messages\": " << numMessages << "," << endl;
+    ss << "  \"malformed\": " << numMalformed << "," << endl;
+    ss << "  \"frames\": " << numFrames << "," << endl;
+    ss << "  \"messagesPerSec\": " << (seconds > 0 ? numMessages / seconds : 0) << "," << endl;
+    ss << "  \"framesPerSec\": " << (seconds > 0 ? numFrames / seconds : 0) << "," << endl;
+    if( hasAllocationCount() ) {
+        ss << "  \"allocations\": " << allocations << "," << endl;
+        ss << "  \"allocationsPerFrame\": " << (numFrames ? (double)allocations / numFrames : 0) << "," << endl;
+    } else {
+        // not counted outside of a KINECT_BENCH_ALLOC_HOOK build //
+        ss << "  \"allocations\": null," << endl;
+        ss << "  \"allocationsPerFrame\": null," << endl;
+    }
+    ss << "  \"stages\": {" << endl;
+    for( int i = 0; i < 4; i++ ) {
+        ss << "    \"" << stages[i].name << "\": { \"p50Us\": " << stages[i].getPercentile(50) << ", \"p99Us\": " << stages[i].getPercentile(99);
+        ss << ", \"maxUs\": " << stages[i].getPercentile(100) << ", \"totalMs\": " << stages[i].getTotal() / 1000.0 << " }" << (i < 3 ? "," : "") << endl;
+    }
+    ss << "  }" << endl;
+    ss << "}" << endl;
+    
+    cout << ss.str();
+    if( asettings.outputPath != "" ) {
+        ofBuffer tbuffer;
+        tbuffer.set( ss.str() );
+        if( !ofBufferToFile( asettings.outputPath, tbuffer ) ) {
+            ofLogError("ReplayBenchmark") << "could not write " << asettings.outputPath;
+            return 1;
+        }
+    }
+    return 0;
+}
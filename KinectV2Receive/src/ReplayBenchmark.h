@@ -0,0 +1,49 @@
+//
+//  ReplayBenchmark.h
+//  KinectV2Receive
+//
+//  Headless replay of a recording through the whole receive pipeline, as fast
+//  as it goes: OSC decoding, skeleton assembly, fusion and filtering, particle
+//  simulation and draw list building. Nothing is drawn and no window is opened.
+//
+//      KinectV2Receive --bench [recording] [--passes N] [--fps F] [--particles N] [--out results.json]
+//
+//  Results are written as JSON to stdout and to --out if given.
+//
+
+#pragma once
+#include "ofMain.h"
+
+class ReplayBenchmark {
+public:
+    class Settings {
+    public:
+        // the newest recording in data/recordings when empty //
+        string recordingPath;
+        string outputPath;
+        int passes = 10;
+        float frameRate = 60;
+        size_t maxParticles = 2000;
+    };
+    
+    class StageTimes {
+    public:
+        string name;
+        // microseconds, one per frame //
+        vector< double > samples;
+        
+        double getPercentile( double apercent ) const;
+        double getTotal() const;
+    };
+    
+    // true if the arguments ask for the benchmark //
+    static bool parseArgs( int argc, char* argv[], Settings& asettings );
+    // returns the process exit code //
+    static int run( const Settings& asettings );
+    
+    // false unless built with KINECT_BENCH_ALLOC_HOOK, which replaces the global
+    // operator new of the whole app to count them //
+    static bool hasAllocationCount();
+    // allocations made through operator new since the start of the process //
+    static uint64_t getNumAllocations();
+};
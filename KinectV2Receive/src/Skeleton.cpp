@@ -7,173 +7,240 @@
 
 #include "Skeleton.h"
 
-//--------------------------------------------------------------
-void Skeleton::build() {
-    for( int i = 0; i < TOTAL_JOINTS; i++ ) {
-        addOrUpdateJoint( getNameForIndex((JointIndex)i), ofVec3f(), false );
-    }
-}
+const char* const Skeleton::JOINT_NAMES[ Skeleton::TOTAL_JOINTS ] = {
+    "SpineBase",
+    "SpineMid",
+    "SpineShoulder",
+    "Neck",
+    "Head",
+    "ShoulderLeft",
+    "ElbowLeft",
+    "WristLeft",
+    "HandLeft",
+    "HandTipLeft",
+    "ThumbLeft",
+    "ShoulderRight",
+    "ElbowRight",
+    "WristRight",
+    "HandRight",
+    "HandTipRight",
+    "ThumbRight",
+    "HipLeft",
+    "KneeLeft",
+    "AnkleLeft",
+    "FootLeft",
+    "HipRight",
+    "KneeRight",
+    "AnkleRight",
+    "FootRight"
+};
 
-//--------------------------------------------------------------
-void Skeleton::draw() {
+const uint8_t Skeleton::BONES[ Skeleton::NUM_BONES ][ 2 ] = {
+    { SPINE_BASE, SPINE_MID },
+    { SPINE_MID, SPINE_SHOULDER },
+    { SPINE_SHOULDER, NECK },
+    { NECK, HEAD },
     
-    drawMesh.clear();
-    drawMesh.setMode( OF_PRIMITIVE_LINES );
+    { SPINE_SHOULDER, SHOULDER_LEFT },
+    { SHOULDER_LEFT, ELBOW_LEFT },
+    { ELBOW_LEFT, WRIST_LEFT },
+    { WRIST_LEFT, HAND_LEFT },
+    { HAND_LEFT, HAND_TIP_LEFT },
+    { HAND_LEFT, THUMB_LEFT },
     
-    drawMesh.addVertex( getJoint(SPINE_BASE)->pos );
-    drawMesh.addVertex( getJoint(SPINE_MID)->pos );
-    drawMesh.addVertex( getJoint(SPINE_MID)->pos );
-    drawMesh.addVertex( getJoint(SPINE_SHOULDER)->pos );
-    drawMesh.addVertex( getJoint(SPINE_SHOULDER)->pos );
-    drawMesh.addVertex( getJoint(NECK)->pos );
-    drawMesh.addVertex( getJoint(NECK)->pos );
-    drawMesh.addVertex( getJoint(HEAD)->pos );
+    { SPINE_BASE, HIP_LEFT },
+    { HIP_LEFT, KNEE_LEFT },
+    { KNEE_LEFT, ANKLE_LEFT },
+    { ANKLE_LEFT, FOOT_LEFT },
     
-    drawMesh.addVertex( getJoint(SPINE_SHOULDER)->pos );
-    drawMesh.addVertex( getJoint(SHOULDER_LEFT)->pos );
-    drawMesh.addVertex( getJoint(SHOULDER_LEFT)->pos );
-    drawMesh.addVertex( getJoint(ELBOW_LEFT)->pos );
-    drawMesh.addVertex( getJoint(ELBOW_LEFT)->pos );
-    drawMesh.addVertex( getJoint(WRIST_LEFT)->pos );
-    drawMesh.addVertex( getJoint(WRIST_LEFT)->pos );
-    drawMesh.addVertex( getJoint(HAND_LEFT)->pos );
-    drawMesh.addVertex( getJoint(HAND_LEFT)->pos );
-    drawMesh.addVertex( getJoint(HAND_TIP_LEFT)->pos );
-    drawMesh.addVertex( getJoint(HAND_LEFT)->pos );
-    drawMesh.addVertex( getJoint(THUMB_LEFT)->pos );
-    
-    drawMesh.addVertex( getJoint(SPINE_BASE)->pos );
-    drawMesh.addVertex( getJoint(HIP_LEFT)->pos );
-    drawMesh.addVertex( getJoint(HIP_LEFT)->pos );
-    drawMesh.addVertex( getJoint(KNEE_LEFT)->pos );
-    drawMesh.addVertex( getJoint(KNEE_LEFT)->pos );
-    drawMesh.addVertex( getJoint(ANKLE_LEFT)->pos );
-    drawMesh.addVertex( getJoint(ANKLE_LEFT)->pos );
-    drawMesh.addVertex( getJoint(FOOT_LEFT)->pos );
+    { SPINE_SHOULDER, SHOULDER_RIGHT },
+    { SHOULDER_RIGHT, ELBOW_RIGHT },
+    { ELBOW_RIGHT, WRIST_RIGHT },
+    { WRIST_RIGHT, HAND_RIGHT },
+    { HAND_RIGHT, HAND_TIP_RIGHT },
+    { HAND_RIGHT, THUMB_RIGHT },
     
+    { SPINE_BASE, HIP_RIGHT },
+    { HIP_RIGHT, KNEE_RIGHT },
+    { KNEE_RIGHT, ANKLE_RIGHT },
+    { ANKLE_RIGHT, FOOT_RIGHT }
+};
+
+//--------------------------------------------------------------
+// perfect hash for the names in JOINT_NAMES, the first two chars and the length
+// are enough to tell all 25 apart //
+static inline size_t hashJointName( const char* aname, size_t alength ) {
+    return ((unsigned char)aname[0] + 9 * (unsigned char)aname[1] + alength) & 63;
+}
+
+//--------------------------------------------------------------
+static array< int8_t, 64 > buildJointHashTable() {
+    array< int8_t, 64 > table;
+    table.fill( -1 );
+    for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
+        size_t h = hashJointName( Skeleton::JOINT_NAMES[i], strlen(Skeleton::JOINT_NAMES[i]) );
+        assert( table[h] < 0 && "joint names collide, update hashJointName" );
+        table[h] = (int8_t)i;
+    }
+    return table;
+}
+
+//--------------------------------------------------------------
+static const array< int8_t, 64 >& getJointHashTable() {
+    // built once, thread safe, joints are looked up from the receive and loader threads //
+    static const array< int8_t, 64 > table = buildJointHashTable();
+    return table;
+}
+
+//--------------------------------------------------------------
+void Skeleton::build( float anow ) {
+    for( int f = 0; f < 3; f++ ) {
+        for( int i = 0; i < TOTAL_JOINTS; i++ ) {
+            frames[f].positions[i].set( 0, 0, 0 );
+            frames[f].states[i] = TRACKING_UNKNOWN;
+        }
+        frames[f].jointMask = 0;
+        frames[f].time = 0;
+    }
+    bNewFrame = false;
+    numFrames = 0;
+    lastTimeSeen = anow;
+    firstTimeSeen = -1;
+}
+
+//--------------------------------------------------------------
+void Skeleton::addJointSample( JointIndex aJointIndex, const ofVec3f& aposition, TrackingState astate, float atime ) {
+    uint32_t bit = 1u << aJointIndex;
+    BodyFrame* back = &frames[backFrame];
+    if( back->jointMask & bit ) {
+        // the next frame started before this one was complete //
+        publishFrame();
+        back = &frames[backFrame];
+    }
+    if( back->jointMask == 0 ) {
+        // joints that never arrive keep their last published state //
+        memcpy( back->positions, frames[frontFrame].positions, sizeof(back->positions) );
+        memcpy( back->states, frames[frontFrame].states, sizeof(back->states) );
+        back->time = atime;
+    }
     
-    drawMesh.addVertex( getJoint(SPINE_SHOULDER)->pos );
-    drawMesh.addVertex( getJoint(SHOULDER_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(SHOULDER_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(ELBOW_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(ELBOW_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(WRIST_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(WRIST_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(HAND_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(HAND_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(HAND_TIP_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(HAND_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(THUMB_RIGHT)->pos );
+    back->positions[aJointIndex]    = aposition * 1000.;
+    back->states[aJointIndex]       = (uint8_t)astate;
+    back->jointMask                 |= bit;
     
-    drawMesh.addVertex( getJoint(SPINE_BASE)->pos );
-    drawMesh.addVertex( getJoint(HIP_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(HIP_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(KNEE_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(KNEE_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(ANKLE_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(ANKLE_RIGHT)->pos );
-    drawMesh.addVertex( getJoint(FOOT_RIGHT)->pos );
+    if( back->isComplete() ) {
+        publishFrame();
+    }
+}
+
+//--------------------------------------------------------------
+void Skeleton::publishFrame() {
+    if( frames[backFrame].jointMask == 0 ) return;
     
-    drawMesh.draw();
+    int oldPrev = prevFrame;
+    prevFrame   = frontFrame;
+    frontFrame  = backFrame;
+    backFrame   = oldPrev;
+    frames[backFrame].jointMask = 0;
     
-    for( auto& joint : joints ) {
-        ofDrawCircle( joint.second->pos, 20 );
-        //ofDrawLine( ofVec3f(), joint.second->pos );
+    bNewFrame = true;
+    numFrames++;
+    if( firstTimeSeen < 0 ) {
+        firstTimeSeen = frames[frontFrame].time;
     }
+    lastTimeSeen = frames[frontFrame].time;
 }
 
 //--------------------------------------------------------------
-shared_ptr <Skeleton::Joint> Skeleton::getJoint(string jointName){
-    for( auto joint : joints ){
-        if( joint.first == jointName ){
-            return joint.second;
-        }
+void Skeleton::publishFrame( const BodyFrame& aframe ) {
+    frames[backFrame] = aframe;
+    publishFrame();
+}
+
+//--------------------------------------------------------------
+Skeleton::Joint Skeleton::getJoint( const string& jointName ) const {
+    JointIndex index = getIndexForName( jointName );
+    if( index == TOTAL_JOINTS ) {
+        return Joint();
     }
-    return shared_ptr<Joint>();
+    return getJoint( index );
 }
 
 //--------------------------------------------------------------
-shared_ptr <Skeleton::Joint> Skeleton::getJoint( JointIndex aJointIndex ) {
-    return getJoint( getNameForIndex(aJointIndex) );
+Skeleton::Joint Skeleton::getJoint( JointIndex aJointIndex ) const {
+    Joint tjoint;
+    tjoint.name             = JOINT_NAMES[aJointIndex];
+    tjoint.pos              = getPosition( aJointIndex );
+    tjoint.prevPos          = getPreviousPosition( aJointIndex );
+    tjoint.bSeen            = isJointSeen( aJointIndex );
+    tjoint.bNewThisFrame    = bNewFrame && (frames[frontFrame].jointMask & (1u << aJointIndex));
+    return tjoint;
 }
 
 //--------------------------------------------------------------
 string Skeleton::getNameForIndex( JointIndex aindex ) {
-    switch( aindex ) {
-        case SPINE_BASE:
-            return "SpineBase";
-        case SPINE_MID:
-            return "SpineMid";
-        case SPINE_SHOULDER:
-            return "SpineShoulder";
-        case NECK:
-            return "Neck";
-        case HEAD:
-            return "Head";
-        case SHOULDER_LEFT:
-            return "ShoulderLeft";
-        case ELBOW_LEFT:
-            return "ElbowLeft";
-        case WRIST_LEFT:
-            return "WristLeft";
-        case HAND_LEFT:
-            return "HandLeft";
-        case HAND_TIP_LEFT:
-            return "HandTipLeft";
-        case THUMB_LEFT:
-            return "ThumbLeft";
-        case SHOULDER_RIGHT:
-            return "ShoulderRight";
-        case ELBOW_RIGHT:
-            return "ElbowRight";
-        case WRIST_RIGHT:
-            return "WristRight";
-        case HAND_RIGHT:
-            return "HandRight";
-        case HAND_TIP_RIGHT:
-            return "HandTipRight";
-        case THUMB_RIGHT:
-            return "ThumbRight";
-        case HIP_LEFT:
-            return "HipLeft";
-        case KNEE_LEFT:
-            return "KneeLeft";
-        case ANKLE_LEFT:
-            return "AnkleLeft";
-        case FOOT_LEFT:
-            return "FootLeft";
-        case HIP_RIGHT:
-            return "HipRight";
-        case KNEE_RIGHT:
-            return "KneeRight";
-        case ANKLE_RIGHT:
-            return "AnkleRight";
-        case FOOT_RIGHT:
-            return "FootRight";
+    if( aindex < 0 || aindex >= TOTAL_JOINTS ) {
+        return "Unknown";
+    }
+    return JOINT_NAMES[aindex];
+}
+
+//--------------------------------------------------------------
+Skeleton::JointIndex Skeleton::getIndexForName( const string& aname ) {
+    return getIndexForName( aname.c_str(), aname.size() );
+}
+
+//--------------------------------------------------------------
+Skeleton::JointIndex Skeleton::getIndexForName( const char* aname, size_t alength ) {
+    if( alength < 2 ) {
+        return TOTAL_JOINTS;
+    }
+    int index = getJointHashTable()[ hashJointName(aname, alength) ];
+    if( index < 0 || strncmp( JOINT_NAMES[index], aname, alength ) != 0 || JOINT_NAMES[index][alength] != 0 ) {
+        return TOTAL_JOINTS;
+    }
+    return (JointIndex)index;
+}
+
+//--------------------------------------------------------------
+Skeleton::TrackingState Skeleton::getTrackingStateForName( const string& aname ) {
+    if( aname == "Tracked" ) return TRACKING_TRACKED;
+    if( aname == "Inferred" ) return TRACKING_INFERRED;
+    if( aname == "NotTracked" ) return TRACKING_NOT_TRACKED;
+    return TRACKING_UNKNOWN;
+}
+
+//--------------------------------------------------------------
+string Skeleton::getNameForTrackingState( TrackingState astate ) {
+    switch( astate ) {
+        case TRACKING_TRACKED:
+            return "Tracked";
+        case TRACKING_INFERRED:
+            return "Inferred";
+        case TRACKING_NOT_TRACKED:
+            return "NotTracked";
         default:
             return "Unknown";
-            
     }
     return "Unknown";
 }
 
 //--------------------------------------------------------------
-void Skeleton::addOrUpdateJoint(string jointName, ofVec3f position, bool seen){
-    
-    if( joints.count(jointName) == 0 ){
-//        ofLogError() << " all joints should be made at startup! jointName = " << jointName <<  endl;
-        //will crash here - so lets make a shared_ptr
-        joints[jointName] = shared_ptr <Joint>( new Joint() );
-        joints[jointName]->name = jointName;
-    }
-    
-    joints[jointName]->pos      = position * 1000.;
-    joints[jointName]->bSeen    = seen;
-    joints[jointName]->bNewThisFrame = true;
-    
-    if( firstTimeSeen < 0 ) {
-        firstTimeSeen = lastTimeSeen;
+bool Skeleton::isSeen( TrackingState astate ) {
+    return (astate != TRACKING_NOT_TRACKED && astate != TRACKING_UNKNOWN);
+}
+
+//--------------------------------------------------------------
+void Skeleton::addOrUpdateJoint( const string& jointName, ofVec3f position, bool seen ) {
+    JointIndex index = getIndexForName( jointName );
+    if( index == TOTAL_JOINTS ) {
+        ofLogWarning("Skeleton::addOrUpdateJoint") << "unknown joint " << jointName;
+        return;
     }
-    lastTimeSeen = ofGetElapsedTimef();
+    addOrUpdateJoint( index, position, seen );
 }
 
+//--------------------------------------------------------------
+void Skeleton::addOrUpdateJoint( JointIndex aJointIndex, ofVec3f position, bool seen ) {
+    addJointSample( aJointIndex, position, seen ? TRACKING_TRACKED : TRACKING_NOT_TRACKED, ofGetElapsedTimef() );
+}
@@ -40,30 +40,90 @@ public:
         TOTAL_JOINTS
     };
     
+    // trackingState argument sent by the Kinect v2 OSC bridge //
+    enum TrackingState {
+        TRACKING_UNKNOWN = 0,
+        TRACKING_NOT_TRACKED,
+        TRACKING_INFERRED,
+        TRACKING_TRACKED
+    };
+    
+    static const uint32_t ALL_JOINTS_MASK = (1u << TOTAL_JOINTS) - 1;
+    
+    // one sensor frame of a body, the joints laid out as structure of arrays //
+    class BodyFrame {
+    public:
+        ofVec3f positions[ TOTAL_JOINTS ];
+        uint8_t states[ TOTAL_JOINTS ];
+        // bit per JointIndex, set for the joints received for this frame //
+        uint32_t jointMask = 0;
+        float time = 0;
+        
+        bool isComplete() const { return jointMask == ALL_JOINTS_MASK; }
+    };
+    
+    // copy of a single joint, for code that still works with joint names //
     class Joint{
     public:
         string name = "Default";
         ofVec3f pos, prevPos;
         bool bSeen = false;
-        float lastUpdate=0.0;
         bool bNewThisFrame = false;
     };
     
-    void build();
-    void draw();
+    static const char* const JOINT_NAMES[ TOTAL_JOINTS ];
+    // bone topology as pairs of joint indices, drawn as lines by SkeletonRenderer //
+    static const int NUM_BONES = 24;
+    static const uint8_t BONES[ NUM_BONES ][ 2 ];
     
-    shared_ptr <Joint> getJoint(string jointName);
-    shared_ptr<Joint> getJoint( JointIndex aJointIndex );
-    string getNameForIndex( JointIndex aindex );
+    // anow in the same clock as the frame times, a body counts as seen at anow //
+    // until its first frame is published //
+    void build( float anow );
     
-    void addOrUpdateJoint(string jointName, ofVec3f position, bool seen);
+    // joint samples are collected into a BodyFrame, which is published once all
+    // joints arrived or once a joint of the next frame shows up //
+    void addJointSample( JointIndex aJointIndex, const ofVec3f& aposition, TrackingState astate, float atime );
+    void publishFrame();
+    // publishes a frame assembled elsewhere, ie. by SkeletonFusion //
+    void publishFrame( const BodyFrame& aframe );
+    // set when a frame was published since the last clearNewFrame() //
+    bool hasNewFrame() const { return bNewFrame; }
+    void clearNewFrame() { bNewFrame = false; }
+    uint64_t getNumFrames() const { return numFrames; }
+    
+    const BodyFrame& getFrame() const { return frames[frontFrame]; }
+    // filters adjust the published frame in place //
+    BodyFrame& getFrame() { return frames[frontFrame]; }
+    const BodyFrame& getPreviousFrame() const { return frames[prevFrame]; }
+    const ofVec3f& getPosition( JointIndex aJointIndex ) const { return frames[frontFrame].positions[aJointIndex]; }
+    const ofVec3f& getPreviousPosition( JointIndex aJointIndex ) const { return frames[prevFrame].positions[aJointIndex]; }
+    bool isJointSeen( JointIndex aJointIndex ) const { return isSeen( (TrackingState)frames[frontFrame].states[aJointIndex] ); }
+    const ofVec3f* getPositions() const { return frames[frontFrame].positions; }
+    const ofVec3f* getPreviousPositions() const { return frames[prevFrame].positions; }
+    
+    Joint getJoint( const string& jointName ) const;
+    Joint getJoint( JointIndex aJointIndex ) const;
+    static string getNameForIndex( JointIndex aindex );
+    // returns TOTAL_JOINTS if the name is not a Kinect v2 joint //
+    static JointIndex getIndexForName( const string& aname );
+    static JointIndex getIndexForName( const char* aname, size_t alength );
+    
+    static TrackingState getTrackingStateForName( const string& aname );
+    static string getNameForTrackingState( TrackingState astate );
+    static bool isSeen( TrackingState astate );
+    
+    void addOrUpdateJoint( const string& jointName, ofVec3f position, bool seen );
+    void addOrUpdateJoint( JointIndex aJointIndex, ofVec3f position, bool seen );
     
     float firstTimeSeen = -1;
     float lastTimeSeen = 0;
     
 protected:
-    map <string, shared_ptr<Joint> > joints;
-    ofMesh drawMesh;
-    
-    
+    // published, previous and assembling frames, rotated on publish instead of copied //
+    BodyFrame frames[3];
+    int frontFrame = 0;
+    int prevFrame = 1;
+    int backFrame = 2;
+    bool bNewFrame = false;
+    uint64_t numFrames = 0;
 };
@@ -0,0 +1,118 @@
+//
+//  SkeletonFilter.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonFilter.h"
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_IX86)
+#include <xmmintrin.h>
+#define FILTER_USE_SSE
+#endif
+
+//--------------------------------------------------------------
+void SkeletonFilter::update( SkeletonTable& askeletons ) {
+    if( !bEnabled ) return;
+    for( size_t i = 0; i < askeletons.size(); i++ ) {
+        Skeleton& skeleton = askeletons.getSkeleton(i);
+        if( !skeleton.hasNewFrame() ) continue;
+        SkeletonTable::Handle thandle = askeletons.getHandle(i);
+        filter( thandle.slot, thandle.generation, skeleton.getFrame() );
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonFilter::clear() {
+    values.clear();
+    derivatives.clear();
+    generations.clear();
+    times.clear();
+    bInitialized.clear();
+}
+
+//--------------------------------------------------------------
+void SkeletonFilter::reserve( uint32_t anumSlots ) {
+    if( generations.size() >= anumSlots ) return;
+    values.resize( (size_t)anumSlots * STRIDE, 0.f );
+    derivatives.resize( (size_t)anumSlots * STRIDE, 0.f );
+    generations.resize( anumSlots, 0 );
+    times.resize( anumSlots, 0.f );
+    bInitialized.resize( anumSlots, 0 );
+}
+
+//--------------------------------------------------------------
+void SkeletonFilter::filter( uint32_t aslot, uint32_t agen, Skeleton::BodyFrame& aframe ) {
+    reserve( aslot + 1 );
+    float* tvalues = &values[ (size_t)aslot * STRIDE ];
+    float* tderivs = &derivatives[ (size_t)aslot * STRIDE ];
+    
+    // ofVec3f is three packed floats //
+    memcpy( scratch, &aframe.positions[0].x, NUM_CHANNELS * sizeof(float) );
+    for( int c = NUM_CHANNELS; c < STRIDE; c++ ) scratch[c] = 0;
+    
+    if( !bInitialized[aslot] || generations[aslot] != agen ) {
+        memcpy( tvalues, scratch, sizeof(scratch) );
+        memset( tderivs, 0, STRIDE * sizeof(float) );
+        generations[aslot]  = agen;
+        times[aslot]        = aframe.time;
+        bInitialized[aslot] = 1;
+        return;
+    }
+    
+    float dt = aframe.time - times[aslot];
+    // frames stamped with the same time, ie. several per update //
+    if( dt <= 0 ) dt = 1.f / 30.f;
+    times[aslot] = aframe.time;
+    
+    for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+        uint8_t state = aframe.states[j];
+        float w = state == Skeleton::TRACKING_TRACKED ? 1.f : (state == Skeleton::TRACKING_INFERRED ? inferredWeight : 0.f);
+        weights[j*3+0] = weights[j*3+1] = weights[j*3+2] = w;
+    }
+    for( int c = NUM_CHANNELS; c < STRIDE; c++ ) weights[c] = 0;
+    
+    // alpha = r / (r + 1) with r = 2 pi cutoff dt //
+    float invDt = 1.f / dt;
+    float rd = TWO_PI * derivativeCutoff * dt;
+    float ad = rd / (rd + 1.f);
+    float rScale = TWO_PI * dt;
+    
+#ifdef FILTER_USE_SSE
+    __m128 vinvDt   = _mm_set1_ps( invDt );
+    __m128 vad      = _mm_set1_ps( ad );
+    __m128 vminCut  = _mm_set1_ps( minCutoff );
+    __m128 vbeta    = _mm_set1_ps( beta );
+    __m128 vrScale  = _mm_set1_ps( rScale );
+    __m128 vone     = _mm_set1_ps( 1.f );
+    __m128 vzero    = _mm_setzero_ps();
+    for( int c = 0; c < STRIDE; c += 4 ) {
+        __m128 x    = _mm_loadu_ps( scratch+c );
+        __m128 prev = _mm_loadu_ps( tvalues+c );
+        __m128 w    = _mm_loadu_ps( weights+c );
+        __m128 delta = _mm_sub_ps( x, prev );
+        
+        __m128 dprev = _mm_loadu_ps( tderivs+c );
+        __m128 dx    = _mm_mul_ps( delta, vinvDt );
+        __m128 edx   = _mm_add_ps( dprev, _mm_mul_ps( _mm_mul_ps( vad, w ), _mm_sub_ps( dx, dprev ) ) );
+        
+        __m128 cutoff = _mm_add_ps( vminCut, _mm_mul_ps( vbeta, _mm_max_ps( edx, _mm_sub_ps( vzero, edx ) ) ) );
+        __m128 r      = _mm_mul_ps( vrScale, cutoff );
+        __m128 a      = _mm_mul_ps( _mm_div_ps( r, _mm_add_ps( r, vone ) ), w );
+        __m128 xhat   = _mm_add_ps( prev, _mm_mul_ps( a, delta ) );
+        
+        _mm_storeu_ps( tvalues+c, xhat );
+        _mm_storeu_ps( tderivs+c, edx );
+    }
+#else
+    for( int c = 0; c < STRIDE; c++ ) {
+        float delta = scratch[c] - tvalues[c];
+        float edx   = tderivs[c] + ad * weights[c] * (delta * invDt - tderivs[c]);
+        float r     = rScale * (minCutoff + beta * fabsf(edx));
+        float a     = r / (r + 1.f) * weights[c];
+        tvalues[c]  += a * delta;
+        tderivs[c]  = edx;
+    }
+#endif
+    
+    memcpy( &aframe.positions[0].x, tvalues, NUM_CHANNELS * sizeof(float) );
+}
@@ -0,0 +1,53 @@
+//
+//  SkeletonFilter.h
+//  KinectV2Receive
+//
+//  One Euro filter over every joint coordinate of every body, run on each newly
+//  published frame before it is drawn or emits particles. The state of a body
+//  is one contiguous block of floats, filtered four coordinates at a time.
+//  Inferred joints follow the raw data more slowly than tracked ones and joints
+//  that are not tracked hold their last filtered position.
+//
+//  http://cristal.univ-lille.fr/~casiez/1euro/
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+#include "SkeletonTable.h"
+
+class SkeletonFilter {
+public:
+    static const int NUM_CHANNELS = Skeleton::TOTAL_JOINTS * 3;
+    // channels per body rounded up to a multiple of 4 //
+    static const int STRIDE = (NUM_CHANNELS + 3) & ~3;
+    
+    bool bEnabled = true;
+    // Hz, the cutoff of a joint at rest //
+    float minCutoff = 1.0;
+    // Hz per mm/s, how fast the cutoff rises with joint speed //
+    float beta = 0.005;
+    // Hz, smoothing of the speed estimate //
+    float derivativeCutoff = 1.0;
+    // blend of an inferred joint compared to a tracked one //
+    float inferredWeight = 0.3;
+    
+    // filters every skeleton in askeletons that has a new frame //
+    void update( SkeletonTable& askeletons );
+    // filters aframe in place, the state of aslot is reset when agen changes //
+    void filter( uint32_t aslot, uint32_t agen, Skeleton::BodyFrame& aframe );
+    void clear();
+    
+protected:
+    void reserve( uint32_t anumSlots );
+    
+    // per slot blocks of STRIDE floats //
+    vector< float > values;
+    vector< float > derivatives;
+    vector< uint32_t > generations;
+    vector< float > times;
+    vector< uint8_t > bInitialized;
+    
+    float scratch[ STRIDE ];
+    float weights[ STRIDE ];
+};
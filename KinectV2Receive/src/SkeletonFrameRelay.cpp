@@ -0,0 +1,239 @@
+//
+//  SkeletonFrameRelay.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonFrameRelay.h"
+
+//--------------------------------------------------------------
+SkeletonFrameRelay::~SkeletonFrameRelay() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool SkeletonFrameRelay::load( string afilePath ) {
+    ofXml xml;
+    if( !xml.load( afilePath ) || !xml.setTo("relay") ) {
+        return false;
+    }
+    maxFrameRate = xml.getValue<float>( "maxFrameRate", maxFrameRate );
+    int numChildren = xml.getNumChildren();
+    for( int i = 0; i < numChildren; i++ ) {
+        if( !xml.setToChild( i ) ) continue;
+        if( xml.getName() == "destination" ) {
+            addDestination( xml.getValue<string>( "host", "127.0.0.1" ), xml.getValue<int>( "port", 12500 ) );
+        }
+        xml.setToParent();
+    }
+    return destinations.size() > 0;
+}
+
+//--------------------------------------------------------------
+bool SkeletonFrameRelay::addDestination( string ahost, int aport ) {
+    if( isThreadRunning() ) {
+        ofLogError("SkeletonFrameRelay") << "addDestination: close the relay first";
+        return false;
+    }
+    unique_ptr< Destination > tdest( new Destination() );
+    tdest->host = ahost;
+    tdest->port = aport;
+    try {
+        tdest->socket.reset( new UdpTransmitSocket( IpEndpointName( ahost.c_str(), aport ) ) );
+    } catch( std::exception& e ) {
+        ofLogError("SkeletonFrameRelay") << "could not send to " << ahost << ":" << aport << ", " << e.what();
+        return false;
+    }
+    tdest->queue.allocate( QUEUE_SIZE );
+    destinations.push_back( std::move(tdest) );
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonFrameRelay::start() {
+    close();
+    if( destinations.empty() ) return;
+    // every destination holds at most a full queue and the packet it is sending, so one is always free //
+    size_t numPackets = destinations.size() * (QUEUE_SIZE + 1) + 1;
+    packets.clear();
+    for( size_t i = 0; i < numPackets; i++ ) {
+        packets.push_back( unique_ptr<Packet>( new Packet() ) );
+        packets.back()->data.resize( MAX_PACKET_SIZE );
+    }
+    nextPacket = 0;
+    nextPublishTime = 0;
+    bWake = false;
+    startThread();
+}
+
+//--------------------------------------------------------------
+void SkeletonFrameRelay::close() {
+    stopThread();
+    wake();
+    waitForThread( false );
+    // whatever was still queued is not sent //
+    uint32_t tindex;
+    for( auto& dest : destinations ) {
+        while( dest->queue.pop( tindex ) ) {}
+    }
+    for( auto& packet : packets ) {
+        packet->refs = 0;
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonFrameRelay::publish( const SkeletonTable& askeletons, float atime ) {
+    if( !isThreadRunning() ) return;
+    
+    // only when a body moved or went away, an update without new frames would resend the last packet //
+    bool bChanged = askeletons.size() != numBodiesPublished;
+    for( size_t i = 0; i < askeletons.size() && !bChanged; i++ ) {
+        bChanged = askeletons.getSkeleton(i).hasNewFrame();
+    }
+    if( !bChanged ) return;
+    
+    if( maxFrameRate > 0 ) {
+        float interval = 1.f / maxFrameRate;
+        // a quarter interval of slack so frame time jitter does not skip every other frame at matching rates //
+        if( atime + interval * 0.25f < nextPublishTime ) {
+            numRateLimited++;
+            return;
+        }
+        nextPublishTime = std::max( nextPublishTime + interval, atime );
+    }
+    
+    Packet* packet = nullptr;
+    uint32_t packetIndex = 0;
+    for( size_t i = 0; i < packets.size(); i++ ) {
+        size_t tindex = (nextPacket + i) % packets.size();
+        if( packets[tindex]->refs.load( std::memory_order_acquire ) == 0 ) {
+            packet = packets[tindex].get();
+            packetIndex = (uint32_t)tindex;
+            nextPacket = tindex + 1;
+            break;
+        }
+    }
+    if( !packet ) return;
+    
+    packet->size = encode( askeletons, sequence++, atime, &packet->data[0] );
+    numBodiesPublished = askeletons.size();
+    
+    // counted up front, the sender may finish with it before the last push //
+    packet->refs.store( (int)destinations.size(), std::memory_order_release );
+    for( auto& dest : destinations ) {
+        if( dest->queue.push( packetIndex ) ) {
+            dest->maxQueueDepth = std::max( dest->maxQueueDepth, dest->queue.size() );
+        } else {
+            dest->numDropped++;
+            packet->refs.fetch_sub( 1, std::memory_order_release );
+        }
+    }
+    wake();
+}
+
+//--------------------------------------------------------------
+vector< SkeletonFrameRelay::Stats > SkeletonFrameRelay::getStats() const {
+    vector< Stats > stats;
+    for( auto& dest : destinations ) {
+        Stats tstats;
+        tstats.host         = dest->host;
+        tstats.port         = dest->port;
+        tstats.numSent      = dest->numSent;
+        tstats.numBytes     = dest->numBytes;
+        tstats.numDropped   = dest->numDropped;
+        tstats.queueDepth   = dest->queue.size();
+        tstats.maxQueueDepth = dest->maxQueueDepth;
+        stats.push_back( tstats );
+    }
+    return stats;
+}
+
+//--------------------------------------------------------------
+size_t SkeletonFrameRelay::encode( const SkeletonTable& askeletons, uint32_t asequence, float atime, char* aout ) {
+    SkeletonFramePacketHeader header;
+    memcpy( header.magic, "KSKF", 4 );
+    header.version      = VERSION;
+    header.numBodies    = 0;
+    header.sequence     = asequence;
+    header.time         = atime;
+    
+    SkeletonFramePacketBody* bodies = (SkeletonFramePacketBody*)(aout + sizeof(SkeletonFramePacketHeader));
+    for( size_t i = 0; i < askeletons.size() && header.numBodies < MAX_BODIES; i++ ) {
+        const Skeleton& skeleton = askeletons.getSkeleton(i);
+        if( !skeleton.getNumFrames() ) continue;
+        const Skeleton::BodyFrame& frame = skeleton.getFrame();
+        SkeletonFramePacketBody& body = bodies[ header.numBodies++ ];
+        body.key = askeletons.getKey(i);
+        memset( body.states, 0, sizeof(body.states) );
+        body.reserved = 0;
+        for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+            for( int k = 0; k < 3; k++ ) {
+                // already in mm //
+                body.positions[j][k] = (int16_t)lrintf( ofClamp( frame.positions[j][k], -32767.f, 32767.f ) );
+            }
+            body.states[ j >> 2 ] |= (frame.states[j] & 0x03) << ((j & 3) * 2);
+        }
+    }
+    memcpy( aout, &header, sizeof(header) );
+    return sizeof(SkeletonFramePacketHeader) + header.numBodies * sizeof(SkeletonFramePacketBody);
+}
+
+//--------------------------------------------------------------
+bool SkeletonFrameRelay::decode( const char* adata, size_t asize, Frame& aframe ) {
+    aframe.keys.clear();
+    aframe.bodies.clear();
+    if( asize < sizeof(SkeletonFramePacketHeader) ) return false;
+    
+    SkeletonFramePacketHeader header;
+    memcpy( &header, adata, sizeof(header) );
+    if( memcmp( header.magic, "KSKF", 4 ) != 0 || header.version != VERSION ) return false;
+    if( asize != sizeof(SkeletonFramePacketHeader) + header.numBodies * sizeof(SkeletonFramePacketBody) ) return false;
+    
+    aframe.sequence = header.sequence;
+    aframe.time     = header.time;
+    aframe.keys.resize( header.numBodies );
+    aframe.bodies.resize( header.numBodies );
+    const char* tptr = adata + sizeof(SkeletonFramePacketHeader);
+    for( size_t i = 0; i < header.numBodies; i++, tptr += sizeof(SkeletonFramePacketBody) ) {
+        SkeletonFramePacketBody body;
+        memcpy( &body, tptr, sizeof(body) );
+        Skeleton::BodyFrame& frame = aframe.bodies[i];
+        aframe.keys[i] = body.key;
+        for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+            frame.positions[j].set( body.positions[j][0], body.positions[j][1], body.positions[j][2] );
+            frame.states[j] = (body.states[ j >> 2 ] >> ((j & 3) * 2)) & 0x03;
+        }
+        frame.jointMask = Skeleton::ALL_JOINTS_MASK;
+        frame.time      = header.time;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonFrameRelay::threadedFunction() {
+    uint32_t tindex;
+    while( isThreadRunning() ) {
+        {
+            std::unique_lock< std::mutex > lock( wakeMutex );
+            wakeCondition.wait_for( lock, std::chrono::milliseconds(100), [this]() { return bWake; } );
+            bWake = false;
+        }
+        for( auto& dest : destinations ) {
+            while( dest->queue.pop( tindex ) ) {
+                Packet& packet = *packets[tindex];
+                dest->socket->Send( &packet.data[0], packet.size );
+                dest->numSent++;
+                dest->numBytes += packet.size;
+                packet.refs.fetch_sub( 1, std::memory_order_release );
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonFrameRelay::wake() {
+    {
+        std::lock_guard< std::mutex > lock( wakeMutex );
+        bWake = true;
+    }
+    wakeCondition.notify_one();
+}
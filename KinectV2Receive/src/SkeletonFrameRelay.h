@@ -0,0 +1,139 @@
+//
+//  SkeletonFrameRelay.h
+//  KinectV2Receive
+//
+//  Rebroadcasts the assembled skeletons to other machines as one UDP packet per
+//  frame holding every body and joint, instead of an OSC message per joint, so
+//  downstream renderers get about 25x fewer packets and nothing to parse.
+//  Destinations can be unicast or multicast addresses.
+//
+//  Packets are built on the main thread and sent by a sender thread. Every
+//  destination has its own queue, one that falls behind drops frames for
+//  itself only, counted in its Stats.
+//
+//  Packet layout (little endian), version 1:
+//      SkeletonFramePacketHeader       16 bytes
+//      SkeletonFramePacketBody[]       numBodies, 166 bytes each
+//  Up to 8 bodies fit in a 1500 byte ethernet frame without fragmenting.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ip/UdpSocket.h"
+#include "Skeleton.h"
+#include "SkeletonTable.h"
+#include "SpscRing.h"
+
+#pragma pack(push, 1)
+struct SkeletonFramePacketHeader {
+    char magic[4];              // "KSKF"
+    uint16_t version;
+    uint16_t numBodies;
+    uint32_t sequence;          // +1 per packet, gaps are lost packets
+    float time;                 // seconds, sender clock
+};
+
+struct SkeletonFramePacketBody {
+    uint64_t key;               // SkeletonTable key, stable while the body is tracked
+    int16_t positions[ Skeleton::TOTAL_JOINTS ][3];    // mm, as in Skeleton
+    uint8_t states[7];          // Skeleton::TrackingState, 2 bits per joint
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+static_assert( sizeof(SkeletonFramePacketHeader) == 16, "SkeletonFramePacketHeader must be 16 bytes" );
+static_assert( sizeof(SkeletonFramePacketBody) == 166, "SkeletonFramePacketBody must be 166 bytes" );
+
+class SkeletonFrameRelay : public ofThread {
+public:
+    static const uint16_t VERSION = 1;
+    static const size_t MAX_BODIES = 32;
+    static const size_t MAX_PACKET_SIZE = sizeof(SkeletonFramePacketHeader) + MAX_BODIES * sizeof(SkeletonFramePacketBody);
+    // packets waiting per destination before it drops frames //
+    static const size_t QUEUE_SIZE = 8;
+    
+    class Stats {
+    public:
+        string host;
+        int port = 0;
+        uint64_t numSent = 0;
+        uint64_t numBytes = 0;
+        // frames skipped because the destination queue was full //
+        uint64_t numDropped = 0;
+        size_t queueDepth = 0;
+        size_t maxQueueDepth = 0;
+    };
+    
+    // a received packet //
+    class Frame {
+    public:
+        uint32_t sequence = 0;
+        float time = 0;
+        vector< uint64_t > keys;
+        // every joint set in jointMask //
+        vector< Skeleton::BodyFrame > bodies;
+    };
+    
+    // least seconds between two packets is 1 / maxFrameRate, every publish() is sent when 0 //
+    float maxFrameRate = 0;
+    
+    ~SkeletonFrameRelay();
+    
+    // reads the destinations and maxFrameRate from a relay settings file, false if there are none //
+    bool load( string afilePath );
+    // before start(), false if the host does not resolve //
+    bool addDestination( string ahost, int aport );
+    size_t getNumDestinations() const { return destinations.size(); }
+    void start();
+    void close();
+    
+    // main thread, queues the bodies of askeletons that have a frame, skipped //
+    // when none of them has a new frame and no body went away since the last packet //
+    void publish( const SkeletonTable& askeletons, float atime );
+    
+    vector< Stats > getStats() const;
+    uint64_t getNumPublished() const { return sequence; }
+    // publish() calls skipped by maxFrameRate //
+    uint64_t getNumRateLimited() const { return numRateLimited; }
+    
+    // writes a packet to aout, at most MAX_BODIES bodies, returns its size //
+    static size_t encode( const SkeletonTable& askeletons, uint32_t asequence, float atime, char* aout );
+    static bool decode( const char* adata, size_t asize, Frame& aframe );
+
+protected:
+    void threadedFunction();
+    void wake();
+    
+    class Packet {
+    public:
+        vector< char > data;
+        size_t size = 0;
+        // destinations still to send it, reused at 0 //
+        atomic< int > refs{0};
+    };
+    
+    class Destination {
+    public:
+        string host;
+        int port = 0;
+        unique_ptr< UdpTransmitSocket > socket;
+        // indices into packets //
+        SpscRing< uint32_t > queue;
+        atomic< uint64_t > numSent{0};
+        atomic< uint64_t > numBytes{0};
+        atomic< uint64_t > numDropped{0};
+        size_t maxQueueDepth = 0;
+    };
+    
+    vector< unique_ptr<Destination> > destinations;
+    vector< unique_ptr<Packet> > packets;
+    size_t nextPacket = 0;
+    uint32_t sequence = 0;
+    size_t numBodiesPublished = 0;
+    float nextPublishTime = 0;
+    uint64_t numRateLimited = 0;
+    
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    bool bWake = false;
+};
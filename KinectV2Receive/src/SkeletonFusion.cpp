@@ -0,0 +1,163 @@
+//
+//  SkeletonFusion.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonFusion.h"
+
+//--------------------------------------------------------------
+vector< SensorCalibration > SensorCalibration::load( string afilePath ) {
+    vector< SensorCalibration > sensors;
+    ofXml xml;
+    if( !xml.load( afilePath ) || !xml.setTo("sensors") ) {
+        return sensors;
+    }
+    int numChildren = xml.getNumChildren();
+    for( int i = 0; i < numChildren; i++ ) {
+        if( !xml.setToChild( i ) ) continue;
+        if( xml.getName() == "sensor" ) {
+            SensorCalibration tsensor;
+            tsensor.port = xml.getValue<int>( "port", 12345 );
+            tsensor.translation.set( xml.getValue<float>("x", 0), xml.getValue<float>("y", 0), xml.getValue<float>("z", 0) );
+            tsensor.rotation.makeRotate( xml.getValue<float>("pitch", 0), ofVec3f(1,0,0), xml.getValue<float>("yaw", 0), ofVec3f(0,1,0), xml.getValue<float>("roll", 0), ofVec3f(0,0,1) );
+            sensors.push_back( tsensor );
+        }
+        xml.setToParent();
+    }
+    return sensors;
+}
+
+//--------------------------------------------------------------
+void SkeletonFusion::update( SkeletonTable& asensorSkeletons, SkeletonTable& afusedSkeletons ) {
+    candidates.clear();
+    cells.clear();
+    float cellSize = std::max( matchDistance, 1.f );
+    
+    for( size_t i = 0; i < asensorSkeletons.size(); i++ ) {
+        const Skeleton& skeleton = asensorSkeletons.getSkeleton(i);
+        if( !skeleton.getNumFrames() ) continue;
+        Candidate tc;
+        tc.index    = (uint32_t)i;
+        tc.key      = asensorSkeletons.getKey(i);
+        tc.sensor   = (uint32_t)(tc.key >> 32);
+        tc.anchor   = skeleton.getPosition( Skeleton::SPINE_MID );
+        tc.cellX    = (int32_t)floor( tc.anchor.x / cellSize );
+        tc.cellZ    = (int32_t)floor( tc.anchor.z / cellSize );
+        tc.cluster  = -1;
+        cells.push_back( make_pair( getCellKey(tc.cellX, tc.cellZ), (uint32_t)candidates.size() ) );
+        candidates.push_back( tc );
+    }
+    std::sort( cells.begin(), cells.end() );
+    
+    nextFusedKeys.clear();
+    claimedFusedKeys.clear();
+    numClusters = 0;
+    float maxDistSq = matchDistance * matchDistance;
+    
+    for( uint32_t c = 0; c < candidates.size(); c++ ) {
+        if( candidates[c].cluster >= 0 ) continue;
+        Candidate& seed = candidates[c];
+        seed.cluster = (int32_t)numClusters;
+        clusterMembers.clear();
+        clusterMembers.push_back( c );
+        
+        // unclaimed bodies of other sensors in this and the 8 surrounding cells //
+        neighbours.clear();
+        for( int dz = -1; dz <= 1; dz++ ) {
+            for( int dx = -1; dx <= 1; dx++ ) {
+                uint64_t cellKey = getCellKey( seed.cellX + dx, seed.cellZ + dz );
+                auto it = std::lower_bound( cells.begin(), cells.end(), make_pair(cellKey, (uint32_t)0) );
+                for( ; it != cells.end() && it->first == cellKey; it++ ) {
+                    const Candidate& other = candidates[ it->second ];
+                    if( other.cluster >= 0 || other.sensor == seed.sensor ) continue;
+                    float distSq = seed.anchor.squareDistance( other.anchor );
+                    if( distSq < maxDistSq ) {
+                        neighbours.push_back( make_pair( distSq, it->second ) );
+                    }
+                }
+            }
+        }
+        // closest first, at most one body per sensor //
+        std::sort( neighbours.begin(), neighbours.end() );
+        for( auto& n : neighbours ) {
+            Candidate& other = candidates[ n.second ];
+            bool bSensorTaken = false;
+            for( uint32_t m : clusterMembers ) {
+                if( candidates[m].sensor == other.sensor ) {
+                    bSensorTaken = true;
+                    break;
+                }
+            }
+            if( bSensorTaken ) continue;
+            other.cluster = seed.cluster;
+            clusterMembers.push_back( n.second );
+        }
+        
+        fuseCluster( asensorSkeletons, afusedSkeletons, clusterMembers );
+        numClusters++;
+    }
+    
+    std::sort( nextFusedKeys.begin(), nextFusedKeys.end() );
+    fusedKeys.swap( nextFusedKeys );
+    
+    // fused bodies no cluster kept, merged into another or with every member gone //
+    std::sort( claimedFusedKeys.begin(), claimedFusedKeys.end() );
+    for( size_t i = afusedSkeletons.size(); i > 0; i-- ) {
+        uint64_t key = afusedSkeletons.getKey( i-1 );
+        if( !std::binary_search( claimedFusedKeys.begin(), claimedFusedKeys.end(), key ) ) {
+            afusedSkeletons.remove( key );
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonFusion::fuseCluster( SkeletonTable& asensorSkeletons, SkeletonTable& afusedSkeletons, const vector<uint32_t>& amembers ) {
+    // keep the fused key of a member that was fused last update //
+    uint64_t fusedKey = 0;
+    bool bFound = false;
+    for( uint32_t m : amembers ) {
+        auto it = std::lower_bound( fusedKeys.begin(), fusedKeys.end(), make_pair(candidates[m].key, (uint64_t)0) );
+        if( it != fusedKeys.end() && it->first == candidates[m].key &&
+           std::find( claimedFusedKeys.begin(), claimedFusedKeys.end(), it->second ) == claimedFusedKeys.end() ) {
+            fusedKey = it->second;
+            bFound = true;
+            break;
+        }
+    }
+    if( !bFound ) {
+        fusedKey = nextKey++;
+    }
+    claimedFusedKeys.push_back( fusedKey );
+    
+    bool bNewFrame = false;
+    for( uint32_t m : amembers ) {
+        nextFusedKeys.push_back( make_pair( candidates[m].key, fusedKey ) );
+        bNewFrame |= asensorSkeletons.getSkeleton( candidates[m].index ).hasNewFrame();
+    }
+    
+    // a new key without a frame yet is not added, it would be drawn with nothing in it //
+    if( !bNewFrame ) return;
+    
+    Skeleton::BodyFrame tframe;
+    tframe.time = 0;
+    for( int j = 0; j < Skeleton::TOTAL_JOINTS; j++ ) {
+        ofVec3f sum, plainSum;
+        float weightSum = 0;
+        uint8_t bestState = Skeleton::TRACKING_UNKNOWN;
+        for( uint32_t m : amembers ) {
+            const Skeleton::BodyFrame& mframe = asensorSkeletons.getSkeleton( candidates[m].index ).getFrame();
+            uint8_t state = mframe.states[j];
+            float weight = state == Skeleton::TRACKING_TRACKED ? 1.f : (state == Skeleton::TRACKING_INFERRED ? inferredWeight : 0.f);
+            sum += mframe.positions[j] * weight;
+            plainSum += mframe.positions[j];
+            weightSum += weight;
+            bestState = std::max( bestState, state );
+            tframe.jointMask |= mframe.jointMask & (1u << j);
+            tframe.time = std::max( tframe.time, mframe.time );
+        }
+        tframe.positions[j] = weightSum > 0 ? sum / weightSum : plainSum / (float)amembers.size();
+        tframe.states[j] = bestState;
+    }
+    Skeleton* fused = afusedSkeletons.get( afusedSkeletons.acquire( fusedKey, tframe.time ) );
+    fused->publishFrame( tframe );
+}
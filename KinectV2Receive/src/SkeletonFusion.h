@@ -0,0 +1,75 @@
+//
+//  SkeletonFusion.h
+//  KinectV2Receive
+//
+//  Merges the skeletons of several sensors into one skeleton per person.
+//
+//  Every sensor has a rigid calibration into the shared room frame, applied to
+//  the joint positions as they arrive. Each update the sensor skeletons are
+//  bucketed on a grid over the floor plane, and bodies from different sensors
+//  whose spines are closer than matchDistance are grouped. Only neighbouring
+//  cells are compared, so matching stays cheap with dozens of bodies. A fused
+//  body keeps its key while any of its members is still in it.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+#include "SkeletonTable.h"
+
+class SensorCalibration {
+public:
+    int port = 12345;
+    // meters, as sent by the bridge //
+    ofVec3f translation;
+    ofQuaternion rotation;
+    
+    ofVec3f apply( const ofVec3f& apos ) const { return rotation * apos + translation; }
+    ofVec3f applyInverse( const ofVec3f& apos ) const { return rotation.inverse() * (apos - translation); }
+    
+    // <sensors><sensor><port/><x/><y/><z/><pitch/><yaw/><roll/></sensor>...</sensors>, angles in degrees //
+    static vector< SensorCalibration > load( string afilePath );
+};
+
+class SkeletonFusion {
+public:
+    // spine distance in millimeters under which bodies of different sensors are one person //
+    float matchDistance = 500;
+    // contribution of an inferred joint, tracked joints count 1 //
+    float inferredWeight = 0.25;
+    
+    // fuses the skeletons of asensorSkeletons, keyed by SkeletonTable::makeKey( sensor, body ),
+    // into afusedSkeletons. A fused frame is published whenever one of its members has a new frame //
+    void update( SkeletonTable& asensorSkeletons, SkeletonTable& afusedSkeletons );
+    
+    size_t getNumCandidates() const { return candidates.size(); }
+    size_t getNumClusters() const { return numClusters; }
+    
+protected:
+    class Candidate {
+    public:
+        uint32_t index;
+        uint32_t sensor;
+        uint64_t key;
+        ofVec3f anchor;
+        int32_t cellX, cellZ;
+        int32_t cluster;
+    };
+    
+    static uint64_t getCellKey( int32_t ax, int32_t az ) { return ((uint64_t)(uint32_t)ax << 32) | (uint32_t)az; }
+    void fuseCluster( SkeletonTable& asensorSkeletons, SkeletonTable& afusedSkeletons, const vector<uint32_t>& amembers );
+    
+    vector< Candidate > candidates;
+    // candidate indices sorted by grid cell //
+    vector< pair<uint64_t, uint32_t> > cells;
+    vector< uint32_t > clusterMembers;
+    vector< pair<float, uint32_t> > neighbours;
+    size_t numClusters = 0;
+    
+    // member key to fused key sorted by member key, from the last update and being
+    // built for this one. Flat vectors so a steady scene does not allocate //
+    vector< pair<uint64_t, uint64_t> > fusedKeys;
+    vector< pair<uint64_t, uint64_t> > nextFusedKeys;
+    vector< uint64_t > claimedFusedKeys;
+    uint64_t nextKey = 0;
+};
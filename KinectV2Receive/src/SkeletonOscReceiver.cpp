@@ -0,0 +1,150 @@
+//
+//  SkeletonOscReceiver.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonOscReceiver.h"
+
+//--------------------------------------------------------------
+SkeletonOscReceiver::~SkeletonOscReceiver() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool SkeletonOscReceiver::setup( int aport, uint32_t asensor ) {
+    close();
+    port = aport;
+    sensor = asensor;
+    ring.allocate( RING_SIZE );
+    try {
+        socket.reset( new UdpListeningReceiveSocket( IpEndpointName( IpEndpointName::ANY_ADDRESS, port ), this ) );
+    } catch( std::exception& e ) {
+        ofLogError("SkeletonOscReceiver::setup") << "could not listen on port " << port << ": " << e.what();
+        socket.reset();
+        return false;
+    }
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonOscReceiver::close() {
+    if( socket ) {
+        socket->AsynchronousBreak();
+        waitForThread( false );
+        socket.reset();
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonOscReceiver::threadedFunction() {
+    FrameProfiler::get().setThreadName( "osc "+ofToString(port) );
+    // returns after AsynchronousBreak() //
+    socket->Run();
+}
+
+//--------------------------------------------------------------
+void SkeletonOscReceiver::ProcessMessage( const osc::ReceivedMessage& amsg, const IpEndpointName& aremoteEndpoint ) {
+    PROFILE_SCOPE( "osc decode" );
+    numReceived++;
+    
+    SkeletonJointSample sample;
+    sample.sensor = sensor;
+    DecodeResult result = decode( amsg, router, sample );
+    if( result == DECODE_IGNORED ) {
+        return;
+    }
+    
+    if( router.getNumBodyIds() > numPublishedBodyIds ) {
+        std::unique_lock<std::mutex> lck( bodyIdMutex );
+        for( ; numPublishedBodyIds < router.getNumBodyIds(); numPublishedBodyIds++ ) {
+            newBodyIds.push_back( router.getBodyId( (uint32_t)numPublishedBodyIds ) );
+        }
+    }
+    
+    if( result == DECODE_MALFORMED ) {
+        numMalformed++;
+        return;
+    }
+    
+    if( !ring.push( sample ) ) {
+        numDropped++;
+    }
+}
+
+//--------------------------------------------------------------
+SkeletonOscReceiver::DecodeResult SkeletonOscReceiver::decode( const osc::ReceivedMessage& amsg, SkeletonOscRouter& arouter, SkeletonJointSample& asample ) {
+    asample.arrivalMicros = ofGetElapsedTimeMicros();
+    
+    const char* address = amsg.AddressPattern();
+    SkeletonOscRouter::Route route = arouter.route( address, strlen(address) );
+    if( route.type != SkeletonOscRouter::ROUTE_JOINT ) {
+        return DECODE_IGNORED;
+    }
+    if( amsg.ArgumentCount() < 4 ) {
+        return DECODE_MALFORMED;
+    }
+    
+    asample.body    = route.body;
+    asample.joint   = route.joint;
+    try {
+        // x, y, z, trackingState //
+        osc::ReceivedMessageArgumentIterator arg = amsg.ArgumentsBegin();
+        asample.pos.x = (arg++)->AsFloat();
+        asample.pos.y = (arg++)->AsFloat();
+        asample.pos.z = (arg++)->AsFloat();
+        const char* state = (arg++)->AsString();
+        asample.state = SkeletonOscRouter::decodeTrackingState( state, strlen(state) );
+    } catch( osc::Exception& e ) {
+        return DECODE_MALFORMED;
+    }
+    return DECODE_JOINT;
+}
+
+//--------------------------------------------------------------
+size_t SkeletonOscReceiver::consume( vector<SkeletonJointSample>& asamples ) {
+    asamples.clear();
+    uint64_t now = ofGetElapsedTimeMicros();
+    uint64_t latencySum = 0;
+    uint64_t latencyMax = 0;
+    
+    SkeletonJointSample sample;
+    while( ring.pop( sample ) ) {
+        uint64_t latency = now > sample.arrivalMicros ? now - sample.arrivalMicros : 0;
+        latencySum += latency;
+        latencyMax = std::max( latencyMax, latency );
+        asamples.push_back( sample );
+    }
+    
+    if( asamples.size() ) {
+        latencyAvgMs = (float)((double)latencySum / asamples.size() / 1000.0);
+        latencyMaxMs = (float)(latencyMax / 1000.0);
+    }
+    return asamples.size();
+}
+
+//--------------------------------------------------------------
+const string& SkeletonOscReceiver::getBodyId( uint32_t abody ) {
+    if( abody >= bodyIds.size() ) {
+        std::unique_lock<std::mutex> lck( bodyIdMutex );
+        bodyIds.insert( bodyIds.end(), newBodyIds.begin(), newBodyIds.end() );
+        newBodyIds.clear();
+    }
+    static const string unknown = "Unknown";
+    if( abody < bodyIds.size() ) {
+        return bodyIds[abody];
+    }
+    return unknown;
+}
+
+//--------------------------------------------------------------
+SkeletonOscReceiver::Stats SkeletonOscReceiver::getStats() const {
+    Stats tstats;
+    tstats.queueDepth   = ring.size();
+    tstats.numReceived  = numReceived;
+    tstats.numDropped   = numDropped;
+    tstats.numMalformed = numMalformed;
+    tstats.latencyAvgMs = latencyAvgMs;
+    tstats.latencyMaxMs = latencyMaxMs;
+    return tstats;
+}
@@ -0,0 +1,93 @@
+//
+//  SkeletonOscReceiver.h
+//  KinectV2Receive
+//
+//  Receives the Kinect v2 OSC bridge on its own thread. Joint messages are
+//  decoded straight from the packet as they arrive and pushed into a lock-free
+//  ring as compact samples, the main thread takes everything ready in one batch.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "osc/OscPacketListener.h"
+#include "ip/UdpSocket.h"
+#include "Skeleton.h"
+#include "SkeletonOscRouter.h"
+#include "SpscRing.h"
+#include "FrameProfiler.h"
+
+class SkeletonJointSample {
+public:
+    // ofGetElapsedTimeMicros() when the packet was decoded //
+    uint64_t arrivalMicros = 0;
+    ofVec3f pos;
+    uint32_t body = 0;
+    // index of the receiver, one per sensor //
+    uint32_t sensor = 0;
+    Skeleton::JointIndex joint = Skeleton::TOTAL_JOINTS;
+    Skeleton::TrackingState state = Skeleton::TRACKING_UNKNOWN;
+};
+
+class SkeletonOscReceiver : public ofThread, public osc::OscPacketListener {
+public:
+    // ~2 seconds of 6 bodies at 30 fps //
+    static const size_t RING_SIZE = 1 << 13;
+    
+    class Stats {
+    public:
+        size_t queueDepth = 0;
+        uint64_t numReceived = 0;
+        uint64_t numDropped = 0;
+        uint64_t numMalformed = 0;
+        // receive to consume latency of the last batch, in milliseconds //
+        float latencyAvgMs = 0;
+        float latencyMaxMs = 0;
+    };
+    
+    enum DecodeResult {
+        DECODE_IGNORED = 0,
+        DECODE_JOINT,
+        DECODE_MALFORMED
+    };
+    
+    ~SkeletonOscReceiver();
+    
+    bool setup( int aport, uint32_t asensor = 0 );
+    void close();
+    
+    // main thread, replaces the contents of asamples with every sample that is ready //
+    size_t consume( vector<SkeletonJointSample>& asamples );
+    // main thread //
+    const string& getBodyId( uint32_t abody );
+    Stats getStats() const;
+    int getPort() const { return port; }
+    
+    // routes and decodes a bridge message into asample, asample.sensor is left alone //
+    static DecodeResult decode( const osc::ReceivedMessage& amsg, SkeletonOscRouter& arouter, SkeletonJointSample& asample );
+    
+protected:
+    void threadedFunction();
+    void ProcessMessage( const osc::ReceivedMessage& amsg, const IpEndpointName& aremoteEndpoint );
+    
+    int port = 0;
+    uint32_t sensor = 0;
+    unique_ptr< UdpListeningReceiveSocket > socket;
+    
+    // receive thread //
+    SkeletonOscRouter router;
+    size_t numPublishedBodyIds = 0;
+    
+    SpscRing< SkeletonJointSample > ring;
+    
+    // new body ids are rare, they are handed over under a lock //
+    std::mutex bodyIdMutex;
+    vector< string > newBodyIds;
+    // main thread copy //
+    vector< string > bodyIds;
+    
+    atomic< uint64_t > numReceived{0};
+    atomic< uint64_t > numDropped{0};
+    atomic< uint64_t > numMalformed{0};
+    float latencyAvgMs = 0;
+    float latencyMaxMs = 0;
+};
@@ -0,0 +1,135 @@
+//
+//  SkeletonOscRouter.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonOscRouter.h"
+
+//--------------------------------------------------------------
+SkeletonOscRouter::SkeletonOscRouter() {
+    clear();
+}
+
+//--------------------------------------------------------------
+void SkeletonOscRouter::clear() {
+    clearRoutes();
+    bodyIds.clear();
+    bodyLookup.clear();
+}
+
+//--------------------------------------------------------------
+void SkeletonOscRouter::clearRoutes() {
+    table.clear();
+    table.resize( 256 );
+    numRoutes = 0;
+}
+
+//--------------------------------------------------------------
+uint64_t SkeletonOscRouter::hashAddress( const char* aaddress, size_t alength ) {
+    // FNV-1a //
+    uint64_t h = 14695981039346656037ULL;
+    for( size_t i = 0; i < alength; i++ ) {
+        h ^= (unsigned char)aaddress[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+//--------------------------------------------------------------
+SkeletonOscRouter::Route SkeletonOscRouter::route( const char* aaddress, size_t alength ) {
+    uint64_t h = hashAddress( aaddress, alength );
+    size_t mask = table.size()-1;
+    size_t i = (size_t)h & mask;
+    while( table[i].bUsed ) {
+        const Entry& e = table[i];
+        if( e.hash == h && e.address.size() == alength && memcmp( e.address.c_str(), aaddress, alength ) == 0 ) {
+            return e.route;
+        }
+        i = (i+1) & mask;
+    }
+    
+    // first time we see this address //
+    if( numRoutes >= MAX_ROUTES ) {
+        clearRoutes();
+        return route( aaddress, alength );
+    }
+    if( (numRoutes+1) * 2 > table.size() ) {
+        grow();
+        return route( aaddress, alength );
+    }
+    
+    Entry& e    = table[i];
+    e.bUsed     = true;
+    e.hash      = h;
+    e.address.assign( aaddress, alength );
+    e.route     = parse( aaddress, alength );
+    numRoutes++;
+    return e.route;
+}
+
+//--------------------------------------------------------------
+void SkeletonOscRouter::grow() {
+    vector< Entry > old;
+    old.swap( table );
+    table.resize( old.size() * 2 );
+    size_t mask = table.size()-1;
+    for( auto& e : old ) {
+        if( !e.bUsed ) continue;
+        size_t i = (size_t)e.hash & mask;
+        while( table[i].bUsed ) {
+            i = (i+1) & mask;
+        }
+        table[i].bUsed  = true;
+        table[i].hash   = e.hash;
+        table[i].address.swap( e.address );
+        table[i].route  = e.route;
+    }
+}
+
+//--------------------------------------------------------------
+SkeletonOscRouter::Route SkeletonOscRouter::parse( const char* aaddress, size_t alength ) {
+    Route troute;
+    vector< string > parts = ofSplitString( string(aaddress, alength), "/", true );
+    if( parts.size() < 4 || parts[0] != "bodies" ) {
+        return troute;
+    }
+    
+    const string& bodyId = parts[1];
+    if( parts[2] == "joints" ) {
+        troute.joint = Skeleton::getIndexForName( parts[3] );
+        if( troute.joint == Skeleton::TOTAL_JOINTS ) {
+            return troute;
+        }
+        troute.type = ROUTE_JOINT;
+    } else if( parts[2] == "hands" ) {
+        troute.type = ROUTE_HAND;
+    } else {
+        return troute;
+    }
+    
+    auto it = bodyLookup.find( bodyId );
+    if( it == bodyLookup.end() ) {
+        it = bodyLookup.insert( make_pair(bodyId, (uint32_t)bodyIds.size()) ).first;
+        bodyIds.push_back( bodyId );
+    }
+    troute.body = it->second;
+    return troute;
+}
+
+//--------------------------------------------------------------
+const string& SkeletonOscRouter::getBodyId( uint32_t abody ) const {
+    static const string unknown = "Unknown";
+    if( abody < bodyIds.size() ) {
+        return bodyIds[abody];
+    }
+    return unknown;
+}
+
+//--------------------------------------------------------------
+Skeleton::TrackingState SkeletonOscRouter::decodeTrackingState( const char* astate, size_t alength ) {
+    // Tracked, Inferred or NotTracked //
+    if( alength == 7 && memcmp( astate, "Tracked", 7 ) == 0 ) return Skeleton::TRACKING_TRACKED;
+    if( alength == 8 && memcmp( astate, "Inferred", 8 ) == 0 ) return Skeleton::TRACKING_INFERRED;
+    if( alength == 10 && memcmp( astate, "NotTracked", 10 ) == 0 ) return Skeleton::TRACKING_NOT_TRACKED;
+    return Skeleton::TRACKING_UNKNOWN;
+}
@@ -0,0 +1,70 @@
+//
+//  SkeletonOscRouter.h
+//  KinectV2Receive
+//
+//  Maps the addresses sent by the Kinect v2 OSC bridge to cached routes.
+//  An address is parsed once, the first time it is seen; after that routing
+//  is a hash and a compare against the interned address, no allocations.
+//
+//  /bodies/{bodyId}/joints/{jointId}
+//  /bodies/{bodyId}/hands/{handId}
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+
+class SkeletonOscRouter {
+public:
+    enum RouteType {
+        ROUTE_NONE = 0,
+        ROUTE_JOINT,
+        ROUTE_HAND
+    };
+    
+    class Route {
+    public:
+        RouteType type = ROUTE_NONE;
+        // index into the interned body ids //
+        uint32_t body = 0;
+        Skeleton::JointIndex joint = Skeleton::TOTAL_JOINTS;
+    };
+    
+    // every new body adds a route per joint and hand, the routes start over past this.
+    // body indices are never reused, so they stay valid across threads //
+    static const size_t MAX_ROUTES = 1 << 16;
+    
+    SkeletonOscRouter();
+    
+    Route route( const char* aaddress, size_t alength );
+    Route route( const string& aaddress ) { return route( aaddress.c_str(), aaddress.size() ); }
+    
+    const string& getBodyId( uint32_t abody ) const;
+    size_t getNumBodyIds() const { return bodyIds.size(); }
+    size_t getNumRoutes() const { return numRoutes; }
+    void clear();
+    void clearRoutes();
+    
+    static Skeleton::TrackingState decodeTrackingState( const char* astate, size_t alength );
+    static Skeleton::TrackingState decodeTrackingState( const string& astate ) { return decodeTrackingState( astate.c_str(), astate.size() ); }
+    
+protected:
+    class Entry {
+    public:
+        uint64_t hash = 0;
+        string address;
+        Route route;
+        bool bUsed = false;
+    };
+    
+    static uint64_t hashAddress( const char* aaddress, size_t alength );
+    Route parse( const char* aaddress, size_t alength );
+    void grow();
+    
+    // open addressing, size is a power of two //
+    vector< Entry > table;
+    size_t numRoutes = 0;
+    
+    vector< string > bodyIds;
+    map< string, uint32_t > bodyLookup;
+};
@@ -0,0 +1,57 @@
+//
+//  SkeletonOscSender.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonOscSender.h"
+
+//--------------------------------------------------------------
+SkeletonOscSender::~SkeletonOscSender() {
+    close();
+}
+
+//--------------------------------------------------------------
+void SkeletonOscSender::setup( const SkeletonRecording* arecording, string ahost, const SensorCalibration& acalibration ) {
+    close();
+    recording   = arecording;
+    calibration = acalibration;
+    sender.setup( ahost, calibration.port );
+    
+    player.setup( recording );
+    player.setLoop( true );
+    player.onRecord = [this]( const SkeletonRecord& rec ) {
+        send( rec );
+    };
+    startThread();
+}
+
+//--------------------------------------------------------------
+void SkeletonOscSender::close() {
+    waitForThread( true );
+}
+
+//--------------------------------------------------------------
+void SkeletonOscSender::threadedFunction() {
+    uint64_t lastMicros = ofGetElapsedTimeMicros();
+    while( isThreadRunning() ) {
+        uint64_t now = ofGetElapsedTimeMicros();
+        player.update( (now - lastMicros) / 1000000.0 );
+        lastMicros = now;
+        sleep( 5 );
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonOscSender::send( const SkeletonRecord& arec ) {
+    // the bridge sends positions in its own sensor frame //
+    ofVec3f tpos = calibration.applyInverse( ofVec3f( arec.x, arec.y, arec.z ) );
+    
+    ofxOscMessage m;
+    m.setAddress( "/bodies/"+recording->getBodyId( arec.body )+"/joints/"+Skeleton::getNameForIndex( (Skeleton::JointIndex)arec.joint ) );
+    m.addFloatArg( tpos.x );
+    m.addFloatArg( tpos.y );
+    m.addFloatArg( tpos.z );
+    m.addStringArg( Skeleton::getNameForTrackingState( (Skeleton::TrackingState)arec.state ) );
+    sender.sendMessage( m, false );
+    numSent++;
+}
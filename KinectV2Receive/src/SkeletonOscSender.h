@@ -0,0 +1,37 @@
+//
+//  SkeletonOscSender.h
+//  KinectV2Receive
+//
+//  Stand-in for a Kinect v2 OSC bridge. Replays a recording on its own thread
+//  and sends the joints to a port, moved out of the room frame with the inverse
+//  of a sensor calibration so the receiving side has something to calibrate and
+//  fuse. Several of these on loopback stand in for a multi sensor room.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "ofxOsc.h"
+#include "SkeletonRecording.h"
+#include "SkeletonPlayer.h"
+#include "SkeletonFusion.h"
+
+class SkeletonOscSender : public ofThread {
+public:
+    ~SkeletonOscSender();
+    
+    // arecording has to stay loaded until the sender is closed //
+    void setup( const SkeletonRecording* arecording, string ahost, const SensorCalibration& acalibration );
+    void close();
+    
+    uint64_t getNumSent() const { return numSent; }
+    
+protected:
+    void threadedFunction();
+    void send( const SkeletonRecord& arec );
+    
+    ofxOscSender sender;
+    SkeletonPlayer player;
+    const SkeletonRecording* recording = nullptr;
+    SensorCalibration calibration;
+    atomic< uint64_t > numSent{0};
+};
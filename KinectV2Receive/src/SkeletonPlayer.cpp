@@ -0,0 +1,331 @@
+//
+//  SkeletonPlayer.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonPlayer.h"
+
+const float SkeletonPlayer::MIN_SPEED       = 0.1f;
+const float SkeletonPlayer::MAX_SPEED       = 10.f;
+const float SkeletonPlayer::MAX_STEP_TIME   = 1.f;
+const float SkeletonPlayer::SNAPSHOT_TIME   = 0.1f;
+const float SkeletonPlayer::MAX_GAP_TIME    = 0.25f;
+
+//--------------------------------------------------------------
+void SkeletonPlayer::setup( const SkeletonRecording* arecording ) {
+    recording   = arecording;
+    time        = 0;
+    cursor      = 0;
+    tracks.clear();
+    numTrackedRecords = 0;
+    windowBegin = 0;
+    windowEnd   = 0;
+    windowTime  = 0;
+    numWindowRecords.clear();
+    bTrackListed.clear();
+    activeTracks.clear();
+    bActiveSorted = true;
+}
+
+//--------------------------------------------------------------
+size_t SkeletonPlayer::getNumRecords() const {
+    if( !recording ) return 0;
+    return recording->getNumRecords();
+}
+
+//--------------------------------------------------------------
+bool SkeletonPlayer::isRecordingComplete() const {
+    return recording && recording->isComplete();
+}
+
+//--------------------------------------------------------------
+float SkeletonPlayer::getDuration() const {
+    size_t numRecords = getNumRecords();
+    if( !numRecords ) return 0.f;
+    return recording->getRecords()[numRecords-1].time;
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::setSpeed( float aspeed ) {
+    speed = ofClamp( aspeed, MIN_SPEED, MAX_SPEED );
+}
+
+//--------------------------------------------------------------
+size_t SkeletonPlayer::findCursor( double atime ) const {
+    const SkeletonRecord* records = recording->getRecords();
+    const SkeletonRecord* it = upper_bound( records, records + getNumRecords(), atime, []( double t, const SkeletonRecord& rec ) {
+        return t < rec.time;
+    });
+    return it - records;
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::emit( size_t abegin, size_t aend ) {
+    // played from the tracks instead, see emitResampled() //
+    if( !onRecord || interpolation != INTERPOLATION_NONE ) return;
+    const SkeletonRecord* records = recording->getRecords();
+    for( size_t i = abegin; i < aend; i++ ) {
+        onRecord( records[i] );
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::emitSnapshot( double atime ) {
+    // replay the last few frames before the playhead so the poses match it //
+    emit( findCursor( atime - SNAPSHOT_TIME ), cursor );
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::seek( float atime ) {
+    if( !getNumRecords() ) return;
+    time    = ofClamp( atime, 0.f, getDuration() );
+    cursor  = findCursor( time );
+    emitSnapshot( time );
+    emitResampled();
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::update( float adeltaTime ) {
+    if( bPaused || !getNumRecords() ) return;
+    
+    double step = (double)adeltaTime * speed;
+    if( step > MAX_STEP_TIME ) {
+        // a long frame hitch, jump instead of replaying everything in between //
+        double duration = getDuration();
+        double target = bReverse ? time - step : time + step;
+        if( bLoop && duration > 0 && isRecordingComplete() ) {
+            target = fmod( target, duration );
+            if( target < 0 ) target += duration;
+        }
+        seek( target );
+        return;
+    }
+    
+    if( bReverse ) {
+        stepBackward( time - step );
+    } else {
+        stepForward( time + step );
+    }
+    emitResampled();
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::stepForward( double atime ) {
+    const SkeletonRecord* records = recording->getRecords();
+    size_t numRecords = getNumRecords();
+    double duration = getDuration();
+    
+    if( atime > duration ) {
+        emit( cursor, numRecords );
+        if( !bLoop || !isRecordingComplete() ) {
+            time = duration;
+            cursor = numRecords;
+            return;
+        }
+        atime = duration > 0 ? fmod( atime - duration, duration ) : 0;
+        time = 0;
+        cursor = 0;
+    }
+    
+    size_t start = cursor;
+    while( cursor < numRecords && records[cursor].time <= atime ) {
+        cursor++;
+    }
+    emit( start, cursor );
+    time = atime;
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::stepBackward( double atime ) {
+    const SkeletonRecord* records = recording->getRecords();
+    size_t numRecords = getNumRecords();
+    double duration = getDuration();
+    double step = time - atime;
+    
+    if( atime < 0 ) {
+        if( !bLoop || !isRecordingComplete() ) {
+            time = 0;
+            cursor = findCursor( 0 );
+            return;
+        }
+        atime = duration > 0 ? duration + fmod( atime, duration ) : 0;
+        time = duration;
+        cursor = numRecords;
+    }
+    
+    while( cursor > 0 && records[cursor-1].time > atime ) {
+        cursor--;
+    }
+    time = atime;
+    
+    // play the records leading up to the playhead in forward order, so the last
+    // sample applied for each joint is the one closest to the playhead //
+    size_t start = cursor;
+    while( start > 0 && records[start-1].time > atime - step ) {
+        start--;
+    }
+    emit( start, cursor );
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::emitResampled() {
+    if( !onRecord || interpolation == INTERPOLATION_NONE ) return;
+    sample( time, resampled );
+    for( auto& rec : resampled ) {
+        onRecord( rec );
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::sample( double atime, vector<SkeletonRecord>& aout ) {
+    aout.clear();
+    if( !getNumRecords() ) return;
+    updateTracks();
+    updateActiveTracks( atime );
+    
+    SkeletonRecord rec;
+    for( uint32_t ttrack : activeTracks ) {
+        if( sampleTrack( tracks[ttrack], atime, rec ) ) {
+            aout.push_back( rec );
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::updateActiveTracks( double atime ) {
+    const SkeletonRecord* records = recording->getRecords();
+    size_t numRecords = getNumRecords();
+    // the same test as sampleTrack(), so the window holds exactly the samples it accepts //
+    auto isTooOld = [atime]( const SkeletonRecord& rec ) { return atime - rec.time > MAX_GAP_TIME; };
+    size_t tbegin = windowBegin;
+    size_t tend = windowEnd;
+    if( fabs( atime - windowTime ) <= MAX_GAP_TIME ) {
+        // played forward or backward a little, walk the ends from where they were //
+        while( tbegin < numRecords && isTooOld( records[tbegin] ) ) tbegin++;
+        while( tbegin > 0 && !isTooOld( records[tbegin-1] ) ) tbegin--;
+        while( tend < numRecords && records[tend].time <= atime ) tend++;
+        while( tend > 0 && records[tend-1].time > atime ) tend--;
+    } else {
+        tbegin = partition_point( records, records + numRecords, isTooOld ) - records;
+        tend = findCursor( atime );
+    }
+    tend = std::max( tbegin, tend );
+    
+    // only the records that left or entered, all of them after a seek //
+    removeFromWindow( windowBegin, std::min( windowEnd, tbegin ) );
+    removeFromWindow( std::max( windowBegin, tend ), windowEnd );
+    addToWindow( tbegin, std::min( tend, windowBegin ) );
+    addToWindow( std::max( tbegin, windowEnd ), tend );
+    windowBegin = tbegin;
+    windowEnd   = tend;
+    windowTime  = atime;
+    
+    // drop the tracks that went empty, in body and joint order so the records of a body are played together //
+    activeTracks.erase( remove_if( activeTracks.begin(), activeTracks.end(), [this]( uint32_t atrack ) {
+        if( numWindowRecords[atrack] ) return false;
+        bTrackListed[atrack] = false;
+        return true;
+    }), activeTracks.end() );
+    if( !bActiveSorted ) {
+        sort( activeTracks.begin(), activeTracks.end() );
+        bActiveSorted = true;
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::addToWindow( size_t abegin, size_t aend ) {
+    const SkeletonRecord* records = recording->getRecords();
+    for( size_t i = abegin; i < aend; i++ ) {
+        const SkeletonRecord& rec = records[i];
+        if( rec.joint >= Skeleton::TOTAL_JOINTS ) continue;
+        size_t ttrack = (size_t)rec.body * Skeleton::TOTAL_JOINTS + rec.joint;
+        if( numWindowRecords[ttrack]++ == 0 && !bTrackListed[ttrack] ) {
+            bTrackListed[ttrack] = true;
+            activeTracks.push_back( (uint32_t)ttrack );
+            bActiveSorted = false;
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::removeFromWindow( size_t abegin, size_t aend ) {
+    const SkeletonRecord* records = recording->getRecords();
+    for( size_t i = abegin; i < aend; i++ ) {
+        const SkeletonRecord& rec = records[i];
+        if( rec.joint >= Skeleton::TOTAL_JOINTS ) continue;
+        numWindowRecords[ (size_t)rec.body * Skeleton::TOTAL_JOINTS + rec.joint ]--;
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonPlayer::updateTracks() {
+    const SkeletonRecord* records = recording->getRecords();
+    size_t numRecords = getNumRecords();
+    for( size_t i = numTrackedRecords; i < numRecords; i++ ) {
+        const SkeletonRecord& rec = records[i];
+        if( rec.joint >= Skeleton::TOTAL_JOINTS ) continue;
+        size_t ttrack = (size_t)rec.body * Skeleton::TOTAL_JOINTS + rec.joint;
+        if( ttrack >= tracks.size() ) {
+            tracks.resize( ((size_t)rec.body + 1) * Skeleton::TOTAL_JOINTS );
+            numWindowRecords.resize( tracks.size(), 0 );
+            bTrackListed.resize( tracks.size(), false );
+        }
+        tracks[ttrack].push_back( (uint32_t)i );
+    }
+    numTrackedRecords = numRecords;
+}
+
+//--------------------------------------------------------------
+bool SkeletonPlayer::sampleTrack( const vector<uint32_t>& atrack, double atime, SkeletonRecord& aout ) const {
+    const SkeletonRecord* records = recording->getRecords();
+    // first sample after atime //
+    size_t next = upper_bound( atrack.begin(), atrack.end(), atime, [records]( double t, uint32_t aindex ) {
+        return t < records[aindex].time;
+    }) - atrack.begin();
+    if( next == 0 ) return false;
+    
+    const SkeletonRecord& r0 = records[ atrack[next-1] ];
+    if( atime - r0.time > MAX_GAP_TIME ) return false;
+    aout        = r0;
+    aout.time   = (float)atime;
+    if( next == atrack.size() ) return true;
+    
+    // only between two samples of a seen joint, otherwise it holds the last one //
+    const SkeletonRecord& r1 = records[ atrack[next] ];
+    float span = r1.time - r0.time;
+    if( span <= 0 || span > MAX_GAP_TIME ) return true;
+    if( !Skeleton::isSeen( (Skeleton::TrackingState)r0.state ) || !Skeleton::isSeen( (Skeleton::TrackingState)r1.state ) ) return true;
+    
+    float u = ofClamp( (atime - r0.time) / span, 0.f, 1.f );
+    ofVec3f p0( r0.x, r0.y, r0.z );
+    ofVec3f p1( r1.x, r1.y, r1.z );
+    ofVec3f p;
+    if( interpolation == INTERPOLATION_CUBIC ) {
+        // cubic hermite, the tangents from the samples on either side scaled to this span //
+        ofVec3f m0 = p1 - p0;
+        ofVec3f m1 = p1 - p0;
+        if( next >= 2 ) {
+            const SkeletonRecord& rm = records[ atrack[next-2] ];
+            if( r0.time - rm.time > 0 && r0.time - rm.time <= MAX_GAP_TIME ) {
+                m0 = (p1 - ofVec3f( rm.x, rm.y, rm.z )) * (span / (r1.time - rm.time));
+            }
+        }
+        if( next + 1 < atrack.size() ) {
+            const SkeletonRecord& r2 = records[ atrack[next+1] ];
+            if( r2.time - r1.time > 0 && r2.time - r1.time <= MAX_GAP_TIME ) {
+                m1 = (ofVec3f( r2.x, r2.y, r2.z ) - p0) * (span / (r2.time - r0.time));
+            }
+        }
+        float u2 = u * u;
+        float u3 = u2 * u;
+        p = p0 * (2.f*u3 - 3.f*u2 + 1.f) + m0 * (u3 - 2.f*u2 + u) + p1 * (-2.f*u3 + 3.f*u2) + m1 * (u3 - u2);
+    } else {
+        p = p0 + (p1 - p0) * u;
+    }
+    aout.x = p.x;
+    aout.y = p.y;
+    aout.z = p.z;
+    // the state of the nearer sample //
+    aout.state = u < 0.5f ? r0.state : r1.state;
+    return true;
+}
@@ -0,0 +1,109 @@
+//
+//  SkeletonPlayer.h
+//  KinectV2Receive
+//
+//  Plays a SkeletonRecording with a cursor into its (immutable) record array.
+//  Records are sorted by time, so seeking is a binary search and stepping
+//  only touches the records that are played.
+//  While a recording is still loading, the playhead waits at the last record
+//  available instead of looping.
+//
+//  With interpolation on, the recorded records are not played. Instead every
+//  update plays one record per joint, resampled at the playhead from the
+//  neighbouring samples of that joint, so the poses move smoothly at any frame
+//  rate instead of stepping at the ~30 Hz of the sensor. Only the joints with a
+//  sample in the last MAX_GAP_TIME are resampled, they are kept in a list that
+//  is updated from the records passing in and out of that window.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SkeletonRecording.h"
+
+class SkeletonPlayer {
+public:
+    static const float MIN_SPEED;
+    static const float MAX_SPEED;
+    // steps longer than this are treated as a seek //
+    static const float MAX_STEP_TIME;
+    // span of records replayed after a seek to rebuild the poses //
+    static const float SNAPSHOT_TIME;
+    // samples of a joint further apart than this are not interpolated, and a
+    // joint without a sample for this long is not played //
+    static const float MAX_GAP_TIME;
+    
+    enum Interpolation {
+        INTERPOLATION_NONE = 0,
+        INTERPOLATION_LINEAR,
+        INTERPOLATION_CUBIC
+    };
+    
+    void setup( const SkeletonRecording* arecording );
+    void update( float adeltaTime );
+    void seek( float atime );
+    
+    void setSpeed( float aspeed );
+    float getSpeed() const { return speed; }
+    void setReverse( bool ab ) { bReverse = ab; }
+    bool isReverse() const { return bReverse; }
+    void setLoop( bool ab ) { bLoop = ab; }
+    bool isLooping() const { return bLoop; }
+    void setPaused( bool ab ) { bPaused = ab; }
+    bool isPaused() const { return bPaused; }
+    void setInterpolation( Interpolation ainterpolation ) { interpolation = ainterpolation; }
+    Interpolation getInterpolation() const { return interpolation; }
+    
+    float getTime() const { return (float)time; }
+    // of the records available so far //
+    float getDuration() const;
+    size_t getCursor() const { return cursor; }
+    
+    // called for every record that is played, in playback order //
+    function< void(const SkeletonRecord&) > onRecord;
+    
+    // one record per joint seen around atime, resampled with the interpolation
+    // set, does not move the playhead. For offline renders at a fixed rate //
+    void sample( double atime, vector<SkeletonRecord>& aout );
+    
+protected:
+    size_t getNumRecords() const;
+    bool isRecordingComplete() const;
+    size_t findCursor( double atime ) const;
+    void emit( size_t abegin, size_t aend );
+    void emitSnapshot( double atime );
+    void stepForward( double atime );
+    void stepBackward( double atime );
+    void emitResampled();
+    // adds the records loaded since the last call to tracks //
+    void updateTracks();
+    // moves the window of records that keep their track active to the ones
+    // within MAX_GAP_TIME before atime //
+    void updateActiveTracks( double atime );
+    void addToWindow( size_t abegin, size_t aend );
+    void removeFromWindow( size_t abegin, size_t aend );
+    bool sampleTrack( const vector<uint32_t>& atrack, double atime, SkeletonRecord& aout ) const;
+    
+    const SkeletonRecording* recording = nullptr;
+    // playhead in recording time, cursor is the index of the first record after it //
+    double time = 0;
+    size_t cursor = 0;
+    float speed = 1.f;
+    bool bReverse = false;
+    bool bLoop = true;
+    bool bPaused = false;
+    Interpolation interpolation = INTERPOLATION_NONE;
+    
+    // record indices per body and joint, in time order, built as records are needed //
+    vector< vector<uint32_t> > tracks;
+    size_t numTrackedRecords = 0;
+    // records [windowBegin, windowEnd) are the ones within MAX_GAP_TIME before the last
+    // sampled time, tracks with any of them are active and the only ones sampled //
+    size_t windowBegin = 0;
+    size_t windowEnd = 0;
+    double windowTime = 0;
+    vector< uint32_t > numWindowRecords;
+    vector< bool > bTrackListed;
+    vector< uint32_t > activeTracks;
+    bool bActiveSorted = true;
+    vector< SkeletonRecord > resampled;
+};
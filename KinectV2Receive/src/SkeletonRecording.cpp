@@ -0,0 +1,445 @@
+//
+//  SkeletonRecording.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonRecording.h"
+#include "SkeletonTrackCodec.h"
+#include "SkeletonTextLoader.h"
+
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+const string SkeletonRecording::FILE_EXTENSION = "kskel";
+
+//--------------------------------------------------------------
+void SkeletonRecordingBuffer::add( float atime, const string& abodyId, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate ) {
+    auto it = bodyLookup.find( abodyId );
+    if( it == bodyLookup.end() ) {
+        it = bodyLookup.insert( make_pair(abodyId, (uint32_t)bodyIds.size()) ).first;
+        bodyIds.push_back( abodyId );
+    }
+
+    SkeletonRecord rec;
+    rec.time    = atime;
+    rec.x       = apos.x;
+    rec.y       = apos.y;
+    rec.z       = apos.z;
+    rec.body    = it->second;
+    rec.joint   = (uint8_t)ajoint;
+    rec.state   = (uint8_t)astate;
+    rec.sensor  = 0;
+    rec.reserved = 0;
+    records.push_back( rec );
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingBuffer::clear() {
+    records.clear();
+    bodyIds.clear();
+    bodyLookup.clear();
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecordingBuffer::save( string afilePath ) const {
+    return SkeletonRecording::save( afilePath, records, bodyIds );
+}
+
+//--------------------------------------------------------------
+SkeletonRecording::~SkeletonRecording() {
+    close();
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::load( string afilePath ) {
+    close();
+    path = afilePath;
+    if( !loadFile( afilePath, false ) ) {
+        path = "";
+        return false;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::loadAsync( string afilePath ) {
+    close();
+    path = afilePath;
+    loadState.store( LOAD_LOADING, std::memory_order_release );
+    bLoadThreadRunning.store( true, std::memory_order_release );
+    loadThread = std::thread( [this, afilePath]() {
+        loadFile( afilePath, true );
+        bLoadThreadRunning.store( false, std::memory_order_release );
+    });
+}
+
+//--------------------------------------------------------------
+const char* SkeletonRecording::mapFile( const string& afullPath, size_t& asize ) {
+#ifndef TARGET_WIN32
+    int fd = open( afullPath.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        ofLogError("SkeletonRecording::load") << "could not open " << afullPath;
+        return nullptr;
+    }
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || st.st_size < (off_t)sizeof(SkeletonRecordingHeader) ) {
+        ofLogError("SkeletonRecording::load") << "file too small to be a recording: " << afullPath;
+        ::close( fd );
+        return nullptr;
+    }
+    void* tdata = mmap( nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+    // the mapping stays valid after the descriptor is closed //
+    ::close( fd );
+    if( tdata == MAP_FAILED ) {
+        ofLogError("SkeletonRecording::load") << "could not map " << afullPath;
+        return nullptr;
+    }
+    // playback walks the records front to back //
+    madvise( tdata, (size_t)st.st_size, MADV_SEQUENTIAL );
+    mappedData = (char*)tdata;
+    mappedSize = (size_t)st.st_size;
+    asize = mappedSize;
+    return mappedData;
+#else
+    ifstream fin( afullPath.c_str(), ios::binary );
+    if( !fin ) {
+        ofLogError("SkeletonRecording::load") << "could not open " << afullPath;
+        return nullptr;
+    }
+    fin.seekg( 0, ios::end );
+    ownedData.resize( (size_t)fin.tellg() );
+    fin.seekg( 0, ios::beg );
+    if( ownedData.size() ) fin.read( &ownedData[0], ownedData.size() );
+    if( ownedData.size() < sizeof(SkeletonRecordingHeader) ) {
+        ofLogError("SkeletonRecording::load") << "file too small to be a recording: " << afullPath;
+        vector< char >().swap( ownedData );
+        return nullptr;
+    }
+    asize = ownedData.size();
+    return &ownedData[0];
+#endif
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::unmapFile() {
+#ifndef TARGET_WIN32
+    if( mappedData ) {
+        munmap( mappedData, mappedSize );
+    }
+#endif
+    mappedData  = nullptr;
+    mappedSize  = 0;
+    vector< char >().swap( ownedData );
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::loadFile( string afilePath, bool abProgressive ) {
+    // legacy text recordings are converted once and played from the binary file //
+    if( ofFilePath::getFileExt(afilePath) == "txt" ) {
+        string binPath = getBinaryPathForText( afilePath );
+        if( !ofFile::doesFileExist(binPath) && !convertTextRecording( afilePath, binPath ) ) {
+            return failLoad();
+        }
+        afilePath = binPath;
+    }
+
+    string fullPath = ofToDataPath( afilePath, true );
+    size_t dataSize = 0;
+    const char* data = mapFile( fullPath, dataSize );
+    if( !data ) {
+        return failLoad();
+    }
+
+    if( SkeletonTrackCodec::isCompressed( data, dataSize ) ) {
+        return loadCompressed( data, dataSize, fullPath, abProgressive );
+    }
+
+    SkeletonRecordingHeader header;
+    memcpy( &header, data, sizeof(header) );
+
+    if( memcmp( header.magic, "KSKL", 4 ) != 0 ) {
+        ofLogError("SkeletonRecording::load") << "not a skeleton recording: " << fullPath;
+        return failLoad();
+    }
+    if( header.version != VERSION || header.recordSize != sizeof(SkeletonRecord) ) {
+        ofLogError("SkeletonRecording::load") << "unsupported recording version " << header.version << ": " << fullPath;
+        return failLoad();
+    }
+    bool bFinalized = (header.flags & FLAG_FINALIZED) != 0;
+    if( !bFinalized ) {
+        ofLogWarning("SkeletonRecording::load") << "recording was not closed cleanly, recovering what was flushed: " << fullPath;
+        // the header is only rewritten after the records it counts are on disk //
+        if( header.recordsOffset >= sizeof(SkeletonRecordingHeader) && header.recordsOffset <= dataSize ) {
+            header.numRecords = std::min( header.numRecords, (uint64_t)((dataSize - header.recordsOffset) / sizeof(SkeletonRecord)) );
+        }
+    }
+    uint64_t recordsEnd = header.recordsOffset + header.numRecords * sizeof(SkeletonRecord);
+    if( header.recordsOffset < sizeof(SkeletonRecordingHeader) || recordsEnd > header.stringTableOffset || header.stringTableOffset > dataSize ) {
+        ofLogError("SkeletonRecording::load") << "corrupt recording: " << fullPath;
+        return failLoad();
+    }
+
+    records         = (const SkeletonRecord*)(data + header.recordsOffset);
+    totalRecords    = (size_t)header.numRecords;
+    numRecords.store( totalRecords, std::memory_order_relaxed );
+
+    if( !readStringTable( data, dataSize, header.stringTableOffset, header.numJointNames, header.numBodyIds, bodyIds ) ) {
+        if( bFinalized ) {
+            ofLogError("SkeletonRecording::load") << "corrupt string table: " << fullPath;
+            return failLoad();
+        }
+        recoverBodyIds();
+    }
+    duration    = header.duration;
+    // the records are read in place, nothing left to do //
+    loadState.store( LOAD_COMPLETE, std::memory_order_release );
+    return true;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::loadCompressed( const char* adata, size_t asize, const string& afullPath, bool abProgressive ) {
+    SkeletonTrackDecoder decoder;
+    if( !decoder.open( adata, asize ) ) {
+        ofLogError("SkeletonRecording::load") << "corrupt compressed recording: " << afullPath;
+        return failLoad();
+    }
+    bodyIds         = decoder.getBodyIds();
+    duration        = decoder.getDuration();
+    totalRecords    = (size_t)decoder.getNumRecords();
+    // sized up front so the records never move while they are played, and left
+    // uninitialized so the first block does not wait for the whole array to be cleared //
+    decodedRecords.reset( totalRecords ? new SkeletonRecord[ totalRecords ] : nullptr );
+    records         = decodedRecords.get();
+
+    size_t numDecoded = 0;
+    for( size_t i = 0; i < decoder.getNumBlocks(); i++ ) {
+        if( bCancelLoad.load( std::memory_order_relaxed ) ) {
+            return false;
+        }
+        const SkeletonTrackBlock& tblock = decoder.getBlock( i );
+        if( !decoder.decodeBlock( i, &decodedRecords[ numDecoded ] ) ) {
+            // keep the blocks before it, as with a recording that was not closed cleanly //
+            ofLogError("SkeletonRecording::load") << "corrupt block " << i << " in " << afullPath << ", playing the first " << numDecoded << " records";
+            break;
+        }
+        numDecoded += tblock.numRecords;
+        numRecords.store( numDecoded, std::memory_order_release );
+        // the first block is a second of playback, enough to start //
+        if( abProgressive && i == 0 ) {
+            loadState.store( LOAD_READY, std::memory_order_release );
+        }
+    }
+
+    // everything was decoded, the file is not needed anymore //
+    unmapFile();
+    loadState.store( LOAD_COMPLETE, std::memory_order_release );
+    return true;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::failLoad() {
+    // runs on the loading thread, so the path stays for the caller to report //
+    unmapFile();
+    records = nullptr;
+    numRecords.store( 0, std::memory_order_relaxed );
+    totalRecords = 0;
+    bodyIds.clear();
+    loadState.store( LOAD_FAILED, std::memory_order_release );
+    return false;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::readStringTable( const char* adata, size_t asize, uint64_t aoffset, uint32_t anumJointNames, uint32_t anumBodyIds, vector<string>& abodyIds ) {
+    if( aoffset > asize ) return false;
+    size_t offset = (size_t)aoffset;
+    uint64_t numStrings = (uint64_t)anumJointNames + anumBodyIds;
+    abodyIds.clear();
+
+    for( uint64_t i = 0; i < numStrings; i++ ) {
+        uint16_t len = 0;
+        if( offset + sizeof(len) > asize ) return false;
+        memcpy( &len, adata + offset, sizeof(len) );
+        offset += sizeof(len);
+        if( offset + len > asize ) return false;
+        string tstr( adata + offset, len );
+        offset += len;
+
+        if( i < anumJointNames ) {
+            // records store the joint index, so the joint layout has to match this build //
+            if( i >= Skeleton::TOTAL_JOINTS || Skeleton::getNameForIndex((Skeleton::JointIndex)i) != tstr ) {
+                ofLogError("SkeletonRecording") << "recorded joint " << i << " '" << tstr << "' does not match the Skeleton joint layout";
+                return false;
+            }
+        } else {
+            abodyIds.push_back( tstr );
+        }
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::recoverBodyIds() {
+    // the ids are lost, but records still tell the bodies apart //
+    uint32_t numBodies = 0;
+    for( size_t i = 0; i < totalRecords; i++ ) {
+        numBodies = std::max( numBodies, records[i].body + 1 );
+    }
+    bodyIds.clear();
+    for( uint32_t i = 0; i < numBodies; i++ ) {
+        bodyIds.push_back( "recovered-"+ofToString(i) );
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::close() {
+    if( loadThread.joinable() ) {
+        // stops between blocks //
+        cancelLoad();
+        loadThread.join();
+    }
+    bCancelLoad.store( false, std::memory_order_relaxed );
+    unmapFile();
+    records     = nullptr;
+    numRecords.store( 0, std::memory_order_relaxed );
+    totalRecords = 0;
+    duration    = 0;
+    decodedRecords.reset();
+    bodyIds.clear();
+    path        = "";
+    loadState.store( LOAD_NONE, std::memory_order_relaxed );
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::isLoaded() const {
+    int tstate = loadState.load( std::memory_order_acquire );
+    return tstate == LOAD_READY || tstate == LOAD_COMPLETE;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::isComplete() const {
+    return loadState.load( std::memory_order_acquire ) == LOAD_COMPLETE;
+}
+
+//--------------------------------------------------------------
+float SkeletonRecording::getLoadProgress() const {
+    if( isComplete() ) return 1.f;
+    if( !isLoaded() || !totalRecords ) return 0.f;
+    return (float)getNumRecords() / totalRecords;
+}
+
+//--------------------------------------------------------------
+string SkeletonRecording::findNewest( string adirectory ) {
+    // recordings are named by timestamp, so the last one is the newest //
+    vector< string > tpaths = list( adirectory );
+    return tpaths.size() ? tpaths.back() : "";
+}
+
+//--------------------------------------------------------------
+vector< string > SkeletonRecording::list( string adirectory ) {
+    ofDirectory tdir;
+    tdir.allowExt( "txt" );
+    tdir.allowExt( FILE_EXTENSION );
+    tdir.allowExt( SkeletonTrackCodec::FILE_EXTENSION );
+    tdir.listDir( adirectory );
+    tdir.sort();
+    vector< string > tpaths;
+    for( size_t i = 0; i < tdir.size(); i++ ) {
+        tpaths.push_back( tdir.getPath(i) );
+    }
+    return tpaths;
+}
+
+//--------------------------------------------------------------
+const string& SkeletonRecording::getBodyId( uint32_t aindex ) const {
+    static const string unknown = "Unknown";
+    if( aindex < bodyIds.size() ) {
+        return bodyIds[aindex];
+    }
+    return unknown;
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::fillHeader( SkeletonRecordingHeader& aheader, uint64_t anumRecords, uint32_t anumBodyIds, float aduration ) {
+    memset( &aheader, 0, sizeof(aheader) );
+    memcpy( aheader.magic, "KSKL", 4 );
+    aheader.version             = VERSION;
+    aheader.recordSize          = sizeof(SkeletonRecord);
+    aheader.flags               = FLAG_FINALIZED;
+    aheader.numJointNames       = Skeleton::TOTAL_JOINTS;
+    aheader.numBodyIds          = anumBodyIds;
+    aheader.numRecords          = anumRecords;
+    aheader.recordsOffset       = sizeof(SkeletonRecordingHeader);
+    aheader.stringTableOffset   = aheader.recordsOffset + anumRecords * sizeof(SkeletonRecord);
+    aheader.duration            = aduration;
+}
+
+//--------------------------------------------------------------
+void SkeletonRecording::writeStringTable( ostream& aout, const vector<string>& abodyIds ) {
+    for( int i = 0; i < Skeleton::TOTAL_JOINTS + (int)abodyIds.size(); i++ ) {
+        string tstr = i < Skeleton::TOTAL_JOINTS ? Skeleton::getNameForIndex((Skeleton::JointIndex)i) : abodyIds[i-Skeleton::TOTAL_JOINTS];
+        uint16_t len = (uint16_t)std::min( tstr.size(), (size_t)USHRT_MAX );
+        aout.write( (const char*)&len, sizeof(len) );
+        aout.write( tstr.c_str(), len );
+    }
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::save( string afilePath, const vector<SkeletonRecord>& arecords, const vector<string>& abodyIds ) {
+    ofstream fout( ofToDataPath(afilePath, true).c_str(), ios::binary | ios::trunc );
+    if( !fout ) {
+        ofLogError("SkeletonRecording::save") << "could not open " << afilePath << " for writing";
+        return false;
+    }
+
+    SkeletonRecordingHeader header;
+    fillHeader( header, arecords.size(), (uint32_t)abodyIds.size(), arecords.size() ? arecords.back().time : 0.f );
+    fout.write( (const char*)&header, sizeof(header) );
+    if( arecords.size() ) {
+        fout.write( (const char*)&arecords[0], arecords.size() * sizeof(SkeletonRecord) );
+    }
+    writeStringTable( fout, abodyIds );
+
+    return fout.good();
+}
+
+//--------------------------------------------------------------
+string SkeletonRecording::getBinaryPathForText( string atxtPath ) {
+    return ofFilePath::removeExt( atxtPath ) + "." + FILE_EXTENSION;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecording::convertTextRecording( string atxtPath, string aoutPath ) {
+    vector< SkeletonRecord > trecords;
+    vector< string > tbodyIds;
+    uint64_t startMicros = ofGetElapsedTimeMicros();
+    if( !SkeletonTextLoader::load( atxtPath, trecords, tbodyIds ) ) {
+        return false;
+    }
+
+    // written under a name of its own and renamed once complete, so a load of aoutPath never //
+    // maps a half written file, also with two conversions of the same recording running //
+    static atomic< uint32_t > numConversions{0};
+    string tempPath = aoutPath + "." + ofToString( numConversions++ ) + ".tmp";
+    if( !save( tempPath, trecords, tbodyIds ) ) {
+        ofFile::removeFile( tempPath );
+        return false;
+    }
+    string fullTempPath = ofToDataPath( tempPath, true );
+    string fullOutPath = ofToDataPath( aoutPath, true );
+    if( std::rename( fullTempPath.c_str(), fullOutPath.c_str() ) != 0 ) {
+        // where rename does not replace, another conversion got there first //
+        ofFile::removeFile( tempPath );
+        if( !ofFile::doesFileExist( aoutPath ) ) {
+            ofLogError("SkeletonRecording") << "could not move the converted recording to " << aoutPath;
+            return false;
+        }
+    }
+
+    ofLogNotice("SkeletonRecording") << "converted " << trecords.size() << " joint samples from " << atxtPath << " to " << aoutPath
+        << " in " << ofToString( (ofGetElapsedTimeMicros() - startMicros) / 1000.0, 1 ) << "ms";
+    return true;
+}
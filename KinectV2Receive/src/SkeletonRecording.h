@@ -0,0 +1,154 @@
+//
+//  SkeletonRecording.h
+//  KinectV2Receive
+//
+//  Binary skeleton recordings, memory mapped for playback.
+//  Compressed recordings, see SkeletonTrackCodec, are decoded into memory instead.
+//  loadAsync() opens a recording on a background thread. Compressed recordings
+//  can be played once their first block is decoded, getNumRecords() grows as the
+//  rest streams in behind the playhead.
+//
+//  Files without FLAG_FINALIZED were still being written, see SkeletonRecordingWriter.
+//
+//  File layout (little endian), version 1:
+//      SkeletonRecordingHeader     64 bytes
+//      SkeletonRecord[]            numRecords, sorted by time
+//      string table                numJointNames joint names, then numBodyIds body ids,
+//                                  each stored as a uint16 length followed by the chars
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+
+#pragma pack(push, 1)
+struct SkeletonRecordingHeader {
+    char magic[4];              // "KSKL"
+    uint16_t version;
+    uint16_t recordSize;        // sizeof(SkeletonRecord)
+    uint32_t flags;
+    uint32_t numJointNames;
+    uint32_t numBodyIds;
+    uint32_t reserved0;
+    uint64_t numRecords;
+    uint64_t recordsOffset;
+    uint64_t stringTableOffset;
+    float duration;
+    uint8_t reserved[12];
+};
+
+// one joint sample, read in place from the mapped file //
+struct SkeletonRecord {
+    float time;                 // seconds since the start of the recording
+    float x, y, z;              // position in meters, in the room frame of SensorCalibration
+    uint32_t body;              // index into the body id table
+    uint8_t joint;              // Skeleton::JointIndex
+    uint8_t state;              // Skeleton::TrackingState
+    uint8_t sensor;             // index of the sensor the body was seen by, 0 in older recordings
+    uint8_t reserved;
+};
+#pragma pack(pop)
+
+static_assert( sizeof(SkeletonRecordingHeader) == 64, "SkeletonRecordingHeader must be 64 bytes" );
+static_assert( sizeof(SkeletonRecord) == 24, "SkeletonRecord must be 24 bytes" );
+
+// collects records in memory, ie. while recording or converting //
+class SkeletonRecordingBuffer {
+public:
+    void add( float atime, const string& abodyId, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate );
+    void clear();
+    bool save( string afilePath ) const;
+
+    vector< SkeletonRecord > records;
+    vector< string > bodyIds;
+
+protected:
+    map< string, uint32_t > bodyLookup;
+};
+
+class SkeletonRecording {
+public:
+    static const uint16_t VERSION = 1;
+    static const uint32_t FLAG_FINALIZED = 1;
+    static const string FILE_EXTENSION;
+
+    enum LoadState {
+        LOAD_NONE = 0,
+        LOAD_LOADING,
+        LOAD_FAILED,
+        // the first records can be played, more are on the way //
+        LOAD_READY,
+        LOAD_COMPLETE
+    };
+
+    SkeletonRecording() {}
+    ~SkeletonRecording();
+
+    // .txt recordings are converted to a .kskel next to them the first time //
+    bool load( string afilePath );
+    // returns right away, nothing but the load state may be read until isLoaded() //
+    void loadAsync( string afilePath );
+    // stops a load in progress, waiting for the loading thread //
+    void close();
+    // asks the loading thread to stop without waiting, see isLoading() //
+    void cancelLoad() { bCancelLoad.store( true, std::memory_order_relaxed ); }
+    // true while the loading thread runs //
+    bool isLoading() const { return bLoadThreadRunning.load( std::memory_order_acquire ); }
+    // true once records can be played //
+    bool isLoaded() const;
+    bool isComplete() const;
+    bool hasFailed() const { return loadState.load( std::memory_order_acquire ) == LOAD_FAILED; }
+    float getLoadProgress() const;
+
+    const SkeletonRecord* getRecords() const { return records; }
+    // the records available so far, all of them once isComplete() //
+    size_t getNumRecords() const { return numRecords.load( std::memory_order_acquire ); }
+    size_t getTotalRecords() const { return totalRecords; }
+    size_t getNumBodyIds() const { return bodyIds.size(); }
+    const vector< string >& getBodyIds() const { return bodyIds; }
+    const string& getBodyId( uint32_t aindex ) const;
+    float getDuration() const { return duration; }
+    const string& getPath() const { return path; }
+
+    static bool save( string afilePath, const vector<SkeletonRecord>& arecords, const vector<string>& abodyIds );
+    // converts a legacy time|address|fVALUE|...|sTracked recording, joint messages only //
+    static bool convertTextRecording( string atxtPath, string aoutPath );
+    static string getBinaryPathForText( string atxtPath );
+    // recordings in adirectory sorted by name, which is their timestamp //
+    static vector< string > list( string adirectory );
+    static string findNewest( string adirectory );
+
+    static void writeStringTable( ostream& aout, const vector<string>& abodyIds );
+    static bool readStringTable( const char* adata, size_t asize, uint64_t aoffset, uint32_t anumJointNames, uint32_t anumBodyIds, vector<string>& abodyIds );
+    static void fillHeader( SkeletonRecordingHeader& aheader, uint64_t anumRecords, uint32_t anumBodyIds, float aduration );
+
+protected:
+    SkeletonRecording( const SkeletonRecording& );
+    SkeletonRecording& operator=( const SkeletonRecording& );
+
+    // runs on the calling thread for load() and on loadThread for loadAsync() //
+    bool loadFile( string afilePath, bool abProgressive );
+    bool loadCompressed( const char* adata, size_t asize, const string& afullPath, bool abProgressive );
+    bool failLoad();
+    const char* mapFile( const string& afullPath, size_t& asize );
+    void unmapFile();
+    void recoverBodyIds();
+
+    string path;
+    char* mappedData = nullptr;
+    size_t mappedSize = 0;
+    vector< char > ownedData;
+    unique_ptr< SkeletonRecord[] > decodedRecords;
+
+    // written by the loading thread before loadState becomes LOAD_READY //
+    const SkeletonRecord* records = nullptr;
+    size_t totalRecords = 0;
+    float duration = 0;
+    vector< string > bodyIds;
+
+    std::atomic< size_t > numRecords{0};
+    std::atomic< int > loadState{LOAD_NONE};
+    std::atomic< bool > bCancelLoad{false};
+    std::atomic< bool > bLoadThreadRunning{false};
+    std::thread loadThread;
+};
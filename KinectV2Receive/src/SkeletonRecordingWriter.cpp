@@ -0,0 +1,229 @@
+//
+//  SkeletonRecordingWriter.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonRecordingWriter.h"
+
+#ifndef TARGET_WIN32
+#include <unistd.h>
+#endif
+
+const float SkeletonRecordingWriter::FLUSH_INTERVAL = 1.f;
+
+//--------------------------------------------------------------
+static void seekTo( FILE* afile, uint64_t aoffset ) {
+    // long is 32 bits on windows and takes can pass 2 GB //
+#ifdef TARGET_WIN32
+    _fseeki64( afile, (__int64)aoffset, SEEK_SET );
+#else
+    fseeko( afile, (off_t)aoffset, SEEK_SET );
+#endif
+}
+
+//--------------------------------------------------------------
+SkeletonRecordingWriter::~SkeletonRecordingWriter() {
+    close();
+    waitForThread( false );
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecordingWriter::open( string afilePath ) {
+    close();
+    // let the previous recording finish writing //
+    waitForThread( false );
+    
+    path = ofToDataPath( afilePath, true );
+    file = fopen( path.c_str(), "wb" );
+    if( !file ) {
+        ofLogError("SkeletonRecordingWriter::open") << "could not open " << path << " for writing";
+        return false;
+    }
+    
+    chunks.resize( NUM_CHUNKS );
+    freeChunks.clear();
+    for( int i = 0; i < (int)NUM_CHUNKS; i++ ) {
+        chunks[i].reserve( CHUNK_SIZE );
+        chunks[i].clear();
+        freeChunks.push_back( i );
+    }
+    fullChunks.clear();
+    pendingBodyIds.clear();
+    pendingDuration = 0;
+    bClosing = false;
+    
+    currentChunk = -1;
+    bodyLookup.clear();
+    numBodies = 0;
+    lastTime = 0;
+    
+    bodyIds.clear();
+    numWrittenRecords = 0;
+    duration = 0;
+    numDropped = 0;
+    numWritten = 0;
+    bFinished = false;
+    
+    // an empty but loadable recording until the first chunk arrives //
+    if( !writeTableAndHeader( false ) ) {
+        fclose( file );
+        file = nullptr;
+        return false;
+    }
+    
+    bOpen = true;
+    startThread();
+    return true;
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingWriter::add( float atime, uint32_t asensor, const string& abodyId, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate ) {
+    if( !bOpen ) return;
+    // a sample stamped just before the last one but consumed after it, kept in order //
+    atime = std::max( atime, lastTime );
+    
+    // two sensors can report the same body id for different people //
+    auto it = bodyLookup.find( make_pair(asensor, abodyId) );
+    if( it == bodyLookup.end() ) {
+        it = bodyLookup.insert( make_pair(make_pair(asensor, abodyId), numBodies++) ).first;
+        std::unique_lock<std::mutex> lck( queueMutex );
+        pendingBodyIds.push_back( abodyId );
+    }
+    
+    if( currentChunk < 0 ) {
+        std::unique_lock<std::mutex> lck( queueMutex );
+        if( freeChunks.empty() ) {
+            numDropped++;
+            return;
+        }
+        currentChunk = freeChunks.back();
+        freeChunks.pop_back();
+        currentChunkStart = atime;
+    }
+    
+    SkeletonRecord rec;
+    rec.time    = atime;
+    rec.x       = apos.x;
+    rec.y       = apos.y;
+    rec.z       = apos.z;
+    rec.body    = it->second;
+    rec.joint   = (uint8_t)ajoint;
+    rec.state   = (uint8_t)astate;
+    rec.sensor  = (uint8_t)asensor;
+    rec.reserved = 0;
+    chunks[currentChunk].push_back( rec );
+    lastTime = atime;
+    
+    if( chunks[currentChunk].size() >= CHUNK_SIZE || atime - currentChunkStart >= FLUSH_INTERVAL ) {
+        submitChunk();
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingWriter::flushIfDue( float atime ) {
+    if( !bOpen || currentChunk < 0 ) return;
+    if( atime - currentChunkStart >= FLUSH_INTERVAL ) {
+        submitChunk();
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingWriter::submitChunk() {
+    if( currentChunk < 0 ) return;
+    std::unique_lock<std::mutex> lck( queueMutex );
+    fullChunks.push_back( currentChunk );
+    pendingDuration = lastTime;
+    currentChunk = -1;
+    queueCondition.notify_one();
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingWriter::close() {
+    if( !bOpen ) return;
+    submitChunk();
+    std::unique_lock<std::mutex> lck( queueMutex );
+    bClosing = true;
+    bOpen = false;
+    queueCondition.notify_one();
+}
+
+//--------------------------------------------------------------
+void SkeletonRecordingWriter::threadedFunction() {
+    FrameProfiler::get().setThreadName( "recording writer" );
+    while( true ) {
+        int chunkIndex = -1;
+        bool bFinish = false;
+        {
+            std::unique_lock<std::mutex> lck( queueMutex );
+            queueCondition.wait( lck, [this]() { return !fullChunks.empty() || bClosing; } );
+            if( !fullChunks.empty() ) {
+                chunkIndex = fullChunks.front();
+                fullChunks.pop_front();
+            } else {
+                bFinish = true;
+            }
+            // body ids are registered before any chunk that references them //
+            bodyIds.insert( bodyIds.end(), pendingBodyIds.begin(), pendingBodyIds.end() );
+            pendingBodyIds.clear();
+            duration = pendingDuration;
+        }
+        
+        if( bFinish ) break;
+        
+        {
+            PROFILE_SCOPE( "write chunk" );
+            writeChunk( chunks[chunkIndex] );
+        }
+        
+        std::unique_lock<std::mutex> lck( queueMutex );
+        chunks[chunkIndex].clear();
+        freeChunks.push_back( chunkIndex );
+    }
+    
+    writeTableAndHeader( true );
+    fclose( file );
+    file = nullptr;
+    ofLogNotice("SkeletonRecordingWriter") << "wrote " << numWrittenRecords << " records to " << path << ", dropped " << numDropped;
+    bFinished = true;
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecordingWriter::writeChunk( const vector<SkeletonRecord>& achunk ) {
+    if( achunk.empty() ) return true;
+    // records go where the string table was, the header still describes the old state //
+    uint64_t offset = sizeof(SkeletonRecordingHeader) + numWrittenRecords * sizeof(SkeletonRecord);
+    seekTo( file, offset );
+    if( fwrite( &achunk[0], sizeof(SkeletonRecord), achunk.size(), file ) != achunk.size() ) {
+        ofLogError("SkeletonRecordingWriter") << "write failed for " << path;
+        return false;
+    }
+    numWrittenRecords += achunk.size();
+    numWritten = numWrittenRecords;
+    return writeTableAndHeader( false );
+}
+
+//--------------------------------------------------------------
+bool SkeletonRecordingWriter::writeTableAndHeader( bool abFinalized ) {
+    uint64_t tableOffset = sizeof(SkeletonRecordingHeader) + numWrittenRecords * sizeof(SkeletonRecord);
+    stringstream table;
+    SkeletonRecording::writeStringTable( table, bodyIds );
+    string tableStr = table.str();
+    seekTo( file, tableOffset );
+    fwrite( tableStr.c_str(), 1, tableStr.size(), file );
+    
+    // the data has to be on disk before the header points at it //
+    fflush( file );
+#ifndef TARGET_WIN32
+    fsync( fileno(file) );
+#endif
+    
+    SkeletonRecordingHeader header;
+    SkeletonRecording::fillHeader( header, numWrittenRecords, (uint32_t)bodyIds.size(), duration );
+    if( !abFinalized ) {
+        header.flags &= ~SkeletonRecording::FLAG_FINALIZED;
+    }
+    seekTo( file, 0 );
+    fwrite( &header, sizeof(header), 1, file );
+    fflush( file );
+    return ferror( file ) == 0;
+}
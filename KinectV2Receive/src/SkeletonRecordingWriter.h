@@ -0,0 +1,78 @@
+//
+//  SkeletonRecordingWriter.h
+//  KinectV2Receive
+//
+//  Streams a SkeletonRecording to disk from a background thread.
+//  Records are collected into fixed size chunks taken from a bounded pool and
+//  handed to the writer thread, so memory stays flat for any length of take.
+//  After every chunk the string table and header are rewritten, so a crash
+//  loses at most the chunks that were not flushed yet.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "FrameProfiler.h"
+#include "SkeletonRecording.h"
+
+class SkeletonRecordingWriter : public ofThread {
+public:
+    // records per chunk and number of chunks in the pool, ~1.5 MB in total //
+    static const size_t CHUNK_SIZE = 4096;
+    static const size_t NUM_CHUNKS = 16;
+    // partially filled chunks are handed off after this many seconds //
+    static const float FLUSH_INTERVAL;
+    
+    ~SkeletonRecordingWriter();
+    
+    bool open( string afilePath );
+    // apos in the room frame, bodies are told apart by sensor and id //
+    void add( float atime, uint32_t asensor, const string& abodyId, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate );
+    // hands off a partially filled chunk once it is FLUSH_INTERVAL old, so it is
+    // written even while no records arrive. Same thread as add(), atime in its clock //
+    void flushIfDue( float atime );
+    // hands off the remaining records, the file is finalized on the writer thread //
+    void close();
+    bool isOpen() const { return bOpen; }
+    // the file was finalized and the thread is done, destroying it does not block //
+    bool isFinished() const { return bFinished; }
+    
+    // records that did not fit in the pool because the disk fell behind //
+    uint64_t getNumDropped() const { return numDropped; }
+    uint64_t getNumWritten() const { return numWritten; }
+    
+protected:
+    void threadedFunction();
+    void submitChunk();
+    bool writeChunk( const vector<SkeletonRecord>& achunk );
+    bool writeTableAndHeader( bool abFinalized );
+    
+    string path;
+    FILE* file = nullptr;
+    bool bOpen = false;
+    
+    // producer side, only touched by the thread calling add() //
+    int currentChunk = -1;
+    float currentChunkStart = 0;
+    map< pair<uint32_t, string>, uint32_t > bodyLookup;
+    uint32_t numBodies = 0;
+    float lastTime = 0;
+    
+    // shared, guarded by queueMutex //
+    std::mutex queueMutex;
+    std::condition_variable queueCondition;
+    vector< vector<SkeletonRecord> > chunks;
+    vector< int > freeChunks;
+    deque< int > fullChunks;
+    vector< string > pendingBodyIds;
+    float pendingDuration = 0;
+    bool bClosing = false;
+    
+    // writer side //
+    vector< string > bodyIds;
+    uint64_t numWrittenRecords = 0;
+    float duration = 0;
+    
+    atomic< uint64_t > numDropped{0};
+    atomic< uint64_t > numWritten{0};
+    atomic< bool > bFinished{false};
+};
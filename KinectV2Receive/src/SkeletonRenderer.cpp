@@ -0,0 +1,81 @@
+//
+//  SkeletonRenderer.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonRenderer.h"
+
+//--------------------------------------------------------------
+void SkeletonRenderer::begin() {
+    numSkeletons = 0;
+}
+
+//--------------------------------------------------------------
+void SkeletonRenderer::add( const Skeleton& askeleton ) {
+    if( numSkeletons >= capacity ) {
+        reserve( std::max( (size_t)8, capacity * 2 ) );
+    }
+    
+    const ofVec3f* positions = askeleton.getPositions();
+    memcpy( &jointVerts[ numSkeletons * Skeleton::TOTAL_JOINTS ], positions, Skeleton::TOTAL_JOINTS * sizeof(ofVec3f) );
+    
+    ofVec3f* tverts = &markerVerts[ numSkeletons * Skeleton::TOTAL_JOINTS * MARKER_VERTS ];
+    for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
+        for( int k = 0; k < MARKER_VERTS; k++ ) {
+            *tverts++ = positions[i] + markerOffsets[k] * markerRadius;
+        }
+    }
+    numSkeletons++;
+}
+
+//--------------------------------------------------------------
+void SkeletonRenderer::reserve( size_t anumSkeletons ) {
+    if( markerOffsets.empty() ) {
+        markerOffsets.push_back( ofVec3f() );
+        for( int k = 0; k < MARKER_RESOLUTION; k++ ) {
+            float angle = TWO_PI * (float)k / (float)MARKER_RESOLUTION;
+            markerOffsets.push_back( ofVec3f( cos(angle), sin(angle), 0 ) );
+        }
+    }
+    
+    jointVerts.resize( anumSkeletons * Skeleton::TOTAL_JOINTS );
+    markerVerts.resize( anumSkeletons * Skeleton::TOTAL_JOINTS * MARKER_VERTS );
+    
+    // topology of the new skeletons, the existing indices stay as they are //
+    for( size_t s = capacity; s < anumSkeletons; s++ ) {
+        ofIndexType jointOffset = (ofIndexType)(s * Skeleton::TOTAL_JOINTS);
+        for( int b = 0; b < Skeleton::NUM_BONES; b++ ) {
+            boneIndices.push_back( jointOffset + Skeleton::BONES[b][0] );
+            boneIndices.push_back( jointOffset + Skeleton::BONES[b][1] );
+        }
+        for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
+            ofIndexType center = (jointOffset + i) * MARKER_VERTS;
+            for( int k = 0; k < MARKER_RESOLUTION; k++ ) {
+                markerIndices.push_back( center );
+                markerIndices.push_back( center + 1 + k );
+                markerIndices.push_back( center + 1 + (k + 1) % MARKER_RESOLUTION );
+            }
+        }
+    }
+    capacity = anumSkeletons;
+    bIndicesDirty = true;
+}
+
+//--------------------------------------------------------------
+void SkeletonRenderer::draw() {
+    if( !numSkeletons ) return;
+    
+    if( bIndicesDirty ) {
+        boneVbo.setVertexData( &jointVerts[0], (int)jointVerts.size(), GL_DYNAMIC_DRAW );
+        boneVbo.setIndexData( &boneIndices[0], (int)boneIndices.size(), GL_STATIC_DRAW );
+        markerVbo.setVertexData( &markerVerts[0], (int)markerVerts.size(), GL_DYNAMIC_DRAW );
+        markerVbo.setIndexData( &markerIndices[0], (int)markerIndices.size(), GL_STATIC_DRAW );
+        bIndicesDirty = false;
+    } else {
+        boneVbo.updateVertexData( &jointVerts[0], (int)(numSkeletons * Skeleton::TOTAL_JOINTS) );
+        markerVbo.updateVertexData( &markerVerts[0], (int)(numSkeletons * Skeleton::TOTAL_JOINTS * MARKER_VERTS) );
+    }
+    
+    boneVbo.drawElements( GL_LINES, (int)(numSkeletons * Skeleton::NUM_BONES * 2) );
+    markerVbo.drawElements( GL_TRIANGLES, (int)(numSkeletons * Skeleton::TOTAL_JOINTS * MARKER_RESOLUTION * 3) );
+}
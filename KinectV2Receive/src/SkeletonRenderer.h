@@ -0,0 +1,44 @@
+//
+//  SkeletonRenderer.h
+//  KinectV2Receive
+//
+//  Draws any number of skeletons with one call for the bones and one for the
+//  joint markers. The index buffers only depend on the skeleton count and are
+//  rebuilt when it grows; the joint positions are copied in place each frame.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+
+class SkeletonRenderer {
+public:
+    static const int MARKER_RESOLUTION = 20;
+    static const int MARKER_VERTS = MARKER_RESOLUTION + 1;
+    
+    float markerRadius = 20;
+    
+    // call begin, add every skeleton, then draw //
+    void begin();
+    void add( const Skeleton& askeleton );
+    void draw();
+    
+    size_t getNumSkeletons() const { return numSkeletons; }
+    
+protected:
+    void reserve( size_t anumSkeletons );
+    
+    size_t numSkeletons = 0;
+    size_t capacity = 0;
+    
+    vector< ofVec3f > jointVerts;
+    vector< ofVec3f > markerVerts;
+    vector< ofIndexType > boneIndices;
+    vector< ofIndexType > markerIndices;
+    // unit circle in the xy plane, like ofDrawCircle //
+    vector< ofVec3f > markerOffsets;
+    
+    ofVbo boneVbo;
+    ofVbo markerVbo;
+    bool bIndicesDirty = false;
+};
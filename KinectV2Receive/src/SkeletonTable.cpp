@@ -0,0 +1,125 @@
+//
+//  SkeletonTable.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonTable.h"
+
+//--------------------------------------------------------------
+SkeletonTable::Handle SkeletonTable::acquire( uint64_t akey, float anow ) {
+    if( lastHandle.isValid() && lastKey == akey ) {
+        return lastHandle;
+    }
+    
+    Handle thandle;
+    auto it = slotForKey.find( akey );
+    if( it != slotForKey.end() ) {
+        thandle.slot = it->second;
+    } else {
+        if( freeSlots.size() ) {
+            thandle.slot = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            thandle.slot = (uint32_t)slots.size();
+            slots.push_back( Slot() );
+        }
+        Slot& tslot = slots[ thandle.slot ];
+        tslot.skeleton.build( anow );
+        tslot.key = akey;
+        tslot.activeIndex = (uint32_t)active.size();
+        active.push_back( thandle.slot );
+        slotForKey[ akey ] = thandle.slot;
+        pushDeadline( thandle.slot );
+    }
+    thandle.generation = slots[ thandle.slot ].generation;
+    
+    lastKey = akey;
+    lastHandle = thandle;
+    return thandle;
+}
+
+//--------------------------------------------------------------
+Skeleton* SkeletonTable::get( Handle ahandle ) {
+    if( ahandle.slot >= slots.size() ) return nullptr;
+    Slot& tslot = slots[ ahandle.slot ];
+    if( tslot.generation != ahandle.generation || tslot.activeIndex == INVALID_SLOT ) return nullptr;
+    return &tslot.skeleton;
+}
+
+//--------------------------------------------------------------
+SkeletonTable::Handle SkeletonTable::getHandle( size_t aindex ) const {
+    Handle thandle;
+    thandle.slot = active[aindex];
+    thandle.generation = slots[ thandle.slot ].generation;
+    return thandle;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTable::remove( uint64_t akey ) {
+    auto it = slotForKey.find( akey );
+    if( it == slotForKey.end() ) return false;
+    // its deadline entry is skipped by reapExpired() once the generation moved on //
+    release( it->second );
+    return true;
+}
+
+//--------------------------------------------------------------
+size_t SkeletonTable::reapExpired( float anow ) {
+    size_t numReaped = 0;
+    while( deadlines.size() && deadlines.front().time <= anow ) {
+        Deadline due = deadlines.front();
+        std::pop_heap( deadlines.begin(), deadlines.end() );
+        deadlines.pop_back();
+        
+        Slot& tslot = slots[ due.slot ];
+        // the body this entry was pushed for is already gone //
+        if( tslot.generation != due.generation || tslot.activeIndex == INVALID_SLOT ) continue;
+        
+        if( getDeadline(tslot) <= anow ) {
+            release( due.slot );
+            numReaped++;
+        } else {
+            // seen since the entry was pushed //
+            pushDeadline( due.slot );
+        }
+    }
+    return numReaped;
+}
+
+//--------------------------------------------------------------
+void SkeletonTable::clear() {
+    for( size_t i = active.size(); i > 0; i-- ) {
+        release( active[i-1] );
+    }
+    deadlines.clear();
+}
+
+//--------------------------------------------------------------
+void SkeletonTable::pushDeadline( uint32_t aslot ) {
+    Deadline tdeadline;
+    tdeadline.time = getDeadline( slots[aslot] );
+    tdeadline.slot = aslot;
+    tdeadline.generation = slots[aslot].generation;
+    deadlines.push_back( tdeadline );
+    std::push_heap( deadlines.begin(), deadlines.end() );
+}
+
+//--------------------------------------------------------------
+void SkeletonTable::release( uint32_t aslot ) {
+    Slot& tslot = slots[ aslot ];
+    
+    // swap and pop from the dense list //
+    uint32_t lastSlot = active.back();
+    active[ tslot.activeIndex ] = lastSlot;
+    slots[ lastSlot ].activeIndex = tslot.activeIndex;
+    active.pop_back();
+    
+    slotForKey.erase( tslot.key );
+    tslot.activeIndex = INVALID_SLOT;
+    tslot.generation++;
+    freeSlots.push_back( aslot );
+    
+    if( lastHandle.slot == aslot ) {
+        lastHandle = Handle();
+    }
+}
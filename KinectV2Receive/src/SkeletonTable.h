@@ -0,0 +1,90 @@
+//
+//  SkeletonTable.h
+//  KinectV2Receive
+//
+//  Owns the live skeletons. Bodies are found by an integer key (source and body
+//  index) instead of the body id string and referred to by handles made of a
+//  slot and a generation, so a handle to an evicted body never resolves to the
+//  body that reuses its slot.
+//
+//  Eviction is deadline ordered: a min heap holds one entry per body, keyed by
+//  the deadline the body had when the entry was pushed. Entries are not touched
+//  when a body is seen again; when an entry comes due and the body has been seen
+//  since, it is pushed again with the new deadline. Reaping only pops entries
+//  that are due, so all expired bodies go in one pass at a cost proportional to
+//  the number expired.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "Skeleton.h"
+
+class SkeletonTable {
+public:
+    static const uint32_t INVALID_SLOT = 0xFFFFFFFF;
+    
+    class Handle {
+    public:
+        uint32_t slot = INVALID_SLOT;
+        uint32_t generation = 0;
+        
+        bool isValid() const { return slot != INVALID_SLOT; }
+        bool operator==( const Handle& aother ) const { return slot == aother.slot && generation == aother.generation; }
+        bool operator!=( const Handle& aother ) const { return !(*this == aother); }
+    };
+    
+    // seconds without a new frame before a body is evicted //
+    float timeout = 2.0;
+    
+    static uint64_t makeKey( uint32_t asource, uint32_t abody ) { return ((uint64_t)asource << 32) | abody; }
+    
+    // the body for akey, created on first sight at anow, the clock of the frame times //
+    Handle acquire( uint64_t akey, float anow );
+    // nullptr once the body was evicted //
+    Skeleton* get( Handle ahandle );
+    // evicts the body for akey now, false if there is none //
+    bool remove( uint64_t akey );
+    // evicts every body not seen for timeout seconds, returns how many //
+    size_t reapExpired( float anow );
+    void clear();
+    
+    // live bodies, densely packed, the order changes on eviction //
+    size_t size() const { return active.size(); }
+    Skeleton& getSkeleton( size_t aindex ) { return slots[ active[aindex] ].skeleton; }
+    const Skeleton& getSkeleton( size_t aindex ) const { return slots[ active[aindex] ].skeleton; }
+    Handle getHandle( size_t aindex ) const;
+    uint64_t getKey( size_t aindex ) const { return slots[ active[aindex] ].key; }
+    
+protected:
+    class Slot {
+    public:
+        Skeleton skeleton;
+        uint64_t key = 0;
+        uint32_t generation = 0;
+        // index into active, INVALID_SLOT while the slot is free //
+        uint32_t activeIndex = INVALID_SLOT;
+    };
+    
+    class Deadline {
+    public:
+        float time;
+        uint32_t slot;
+        uint32_t generation;
+        // min heap on time //
+        bool operator<( const Deadline& aother ) const { return time > aother.time; }
+    };
+    
+    float getDeadline( const Slot& aslot ) const { return aslot.skeleton.lastTimeSeen + timeout; }
+    void pushDeadline( uint32_t aslot );
+    void release( uint32_t aslot );
+    
+    vector< Slot > slots;
+    vector< uint32_t > freeSlots;
+    vector< uint32_t > active;
+    vector< Deadline > deadlines;
+    unordered_map< uint64_t, uint32_t > slotForKey;
+    
+    // samples arrive grouped by body, most lookups hit the last one //
+    uint64_t lastKey = 0;
+    Handle lastHandle;
+};
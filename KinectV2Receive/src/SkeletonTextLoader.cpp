@@ -0,0 +1,366 @@
+//
+//  SkeletonTextLoader.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonTextLoader.h"
+#include "SkeletonOscRouter.h"
+#include "ParallelFor.h"
+
+#ifndef TARGET_WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+// chunks smaller than this are not worth a thread //
+static const size_t MIN_CHUNK_SIZE = 1 << 20;
+
+//--------------------------------------------------------------
+// a range of lines and the bodies seen in it, body names point into the file //
+class TextChunk {
+public:
+    class BodyName {
+    public:
+        const char* name;
+        size_t length;
+    };
+
+    uint32_t findBody( const char* aname, size_t alength );
+
+    const char* begin = nullptr;
+    const char* end = nullptr;
+    size_t firstRecord = 0;
+    size_t numRecords = 0;
+
+    vector< BodyName > bodies;
+    // open addressing, body index + 1, 0 is empty //
+    vector< uint32_t > table;
+    uint32_t lastBody = 0;
+    vector< uint32_t > remap;
+};
+
+//--------------------------------------------------------------
+static inline uint32_t hashName( const char* aname, size_t alength ) {
+    uint32_t h = 2166136261u;
+    for( size_t i = 0; i < alength; i++ ) {
+        h = (h ^ (uint8_t)aname[i]) * 16777619u;
+    }
+    return h;
+}
+
+//--------------------------------------------------------------
+uint32_t TextChunk::findBody( const char* aname, size_t alength ) {
+    // samples of the same body come in runs //
+    if( lastBody < bodies.size() && bodies[lastBody].length == alength && memcmp( bodies[lastBody].name, aname, alength ) == 0 ) {
+        return lastBody;
+    }
+    if( bodies.size() * 2 >= table.size() ) {
+        table.assign( std::max( (size_t)64, table.size() * 2 ), 0 );
+        for( uint32_t i = 0; i < bodies.size(); i++ ) {
+            size_t slot = hashName( bodies[i].name, bodies[i].length ) & (table.size()-1);
+            while( table[slot] ) slot = (slot+1) & (table.size()-1);
+            table[slot] = i+1;
+        }
+    }
+    size_t slot = hashName( aname, alength ) & (table.size()-1);
+    while( table[slot] ) {
+        const BodyName& tbody = bodies[ table[slot]-1 ];
+        if( tbody.length == alength && memcmp( tbody.name, aname, alength ) == 0 ) {
+            lastBody = table[slot]-1;
+            return lastBody;
+        }
+        slot = (slot+1) & (table.size()-1);
+    }
+    BodyName tbody;
+    tbody.name      = aname;
+    tbody.length    = alength;
+    bodies.push_back( tbody );
+    table[slot]     = (uint32_t)bodies.size();
+    lastBody        = (uint32_t)bodies.size()-1;
+    return lastBody;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTextLoader::parseFloat( const char*& aptr, const char* aend, float& avalue ) {
+    // exact powers of ten, so a mantissa of up to 15 digits converts with one rounding //
+    static const double POW10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* p = aptr;
+    bool bNegative = false;
+    if( p < aend && (*p == '-' || *p == '+') ) {
+        bNegative = *p == '-';
+        p++;
+    }
+
+    uint64_t mantissa = 0;
+    int exponent = 0;
+    int numDigits = 0;
+    const char* digitsStart = p;
+    while( p < aend && *p >= '0' && *p <= '9' ) {
+        if( numDigits < 18 ) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if( mantissa ) numDigits++;
+        } else {
+            exponent++;
+        }
+        p++;
+    }
+    bool bHasDigits = p != digitsStart;
+    if( p < aend && *p == '.' ) {
+        p++;
+        const char* fractionStart = p;
+        while( p < aend && *p >= '0' && *p <= '9' ) {
+            if( numDigits < 18 ) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if( mantissa ) numDigits++;
+                exponent--;
+            }
+            p++;
+        }
+        bHasDigits = bHasDigits || p != fractionStart;
+    }
+    if( !bHasDigits ) {
+        return false;
+    }
+    if( p < aend && (*p == 'e' || *p == 'E') ) {
+        const char* e = p+1;
+        bool bNegativeExponent = false;
+        if( e < aend && (*e == '-' || *e == '+') ) {
+            bNegativeExponent = *e == '-';
+            e++;
+        }
+        if( e < aend && *e >= '0' && *e <= '9' ) {
+            int texponent = 0;
+            while( e < aend && *e >= '0' && *e <= '9' ) {
+                if( texponent < 10000 ) texponent = texponent * 10 + (*e - '0');
+                e++;
+            }
+            exponent += bNegativeExponent ? -texponent : texponent;
+            p = e;
+        }
+    }
+
+    double tvalue = (double)mantissa;
+    if( exponent < 0 ) {
+        tvalue = -exponent <= 22 ? tvalue / POW10[-exponent] : tvalue * pow( 10.0, exponent );
+    } else if( exponent > 0 ) {
+        tvalue = exponent <= 22 ? tvalue * POW10[exponent] : tvalue * pow( 10.0, exponent );
+    }
+    avalue = (float)(bNegative ? -tvalue : tvalue);
+    aptr = p;
+    return true;
+}
+
+//--------------------------------------------------------------
+// parses [abegin, aend) of a field with a one char type tag, ie. f0.012054 //
+static inline bool parseTaggedFloat( const char* abegin, const char* aend, float& avalue ) {
+    if( aend - abegin < 2 ) return false;
+    abegin++;
+    return SkeletonTextLoader::parseFloat( abegin, aend, avalue );
+}
+
+//--------------------------------------------------------------
+static bool parseLine( const char* aline, const char* aend, TextChunk& achunk, SkeletonRecord& arec ) {
+    // time|/bodies/{bodyId}/joints/{jointId}|fX|fY|fZ|sTrackingState //
+    const char* fields[7];
+    int numFields = 0;
+    const char* p = aline;
+    while( numFields < 6 ) {
+        fields[numFields++] = p;
+        const char* bar = (const char*)memchr( p, '|', aend - p );
+        if( !bar ) break;
+        p = bar+1;
+    }
+    if( numFields < 6 ) return false;
+    const char* stateEnd = (const char*)memchr( fields[5], '|', aend - fields[5] );
+    fields[6] = (stateEnd ? stateEnd : aend) + 1;
+
+    // address segments, empty ones are skipped //
+    const char* segments[4];
+    size_t segmentLengths[4];
+    int numSegments = 0;
+    const char* addressEnd = fields[2]-1;
+    p = fields[1];
+    while( p < addressEnd && numSegments < 4 ) {
+        while( p < addressEnd && *p == '/' ) p++;
+        const char* segment = p;
+        while( p < addressEnd && *p != '/' ) p++;
+        if( p > segment ) {
+            segments[numSegments]       = segment;
+            segmentLengths[numSegments] = p - segment;
+            numSegments++;
+        }
+    }
+    if( numSegments < 4 || segmentLengths[2] != 6 || memcmp( segments[2], "joints", 6 ) != 0 ) return false;
+
+    Skeleton::JointIndex joint = Skeleton::getIndexForName( segments[3], segmentLengths[3] );
+    if( joint == Skeleton::TOTAL_JOINTS ) return false;
+
+    const char* tp = fields[0];
+    if( !SkeletonTextLoader::parseFloat( tp, fields[1]-1, arec.time ) ) return false;
+    if( !parseTaggedFloat( fields[2], fields[3]-1, arec.x ) ) return false;
+    if( !parseTaggedFloat( fields[3], fields[4]-1, arec.y ) ) return false;
+    if( !parseTaggedFloat( fields[4], fields[5]-1, arec.z ) ) return false;
+
+    const char* state = fields[5];
+    size_t stateLength = fields[6]-1 - state;
+    if( stateLength < 1 ) return false;
+    arec.state      = (uint8_t)SkeletonOscRouter::decodeTrackingState( state+1, stateLength-1 );
+    arec.joint      = (uint8_t)joint;
+    arec.body       = achunk.findBody( segments[1], segmentLengths[1] );
+    arec.sensor     = 0;
+    arec.reserved   = 0;
+    return true;
+}
+
+//--------------------------------------------------------------
+static void parseChunk( TextChunk& achunk, SkeletonRecord* aout ) {
+    const char* p = achunk.begin;
+    size_t count = 0;
+    while( p < achunk.end ) {
+        const char* lineEnd = (const char*)memchr( p, '\n', achunk.end - p );
+        if( !lineEnd ) lineEnd = achunk.end;
+        const char* next = lineEnd < achunk.end ? lineEnd+1 : lineEnd;
+        if( lineEnd > p && lineEnd[-1] == '\r' ) lineEnd--;
+        if( parseLine( p, lineEnd, achunk, aout[count] ) ) {
+            count++;
+        }
+        p = next;
+    }
+    achunk.numRecords = count;
+}
+
+//--------------------------------------------------------------
+static size_t countLines( const char* abegin, const char* aend ) {
+    size_t count = 0;
+    const char* p = abegin;
+    while( p < aend ) {
+        const char* lineEnd = (const char*)memchr( p, '\n', aend - p );
+        count++;
+        if( !lineEnd ) break;
+        p = lineEnd+1;
+    }
+    return count;
+}
+
+//--------------------------------------------------------------
+void SkeletonTextLoader::parse( const char* adata, size_t asize, vector<SkeletonRecord>& arecords, vector<string>& abodyIds, int anumThreads ) {
+    arecords.clear();
+    abodyIds.clear();
+
+    ParallelFor parallelFor;
+    parallelFor.setup( anumThreads );
+    size_t numChunks = std::max( (size_t)1, std::min( (size_t)parallelFor.getNumThreads(), asize / MIN_CHUNK_SIZE ) );
+
+    // chunks end just after a newline //
+    vector< TextChunk > chunks( numChunks );
+    const char* end = adata + asize;
+    const char* p = adata;
+    for( size_t i = 0; i < numChunks; i++ ) {
+        chunks[i].begin = p;
+        if( i+1 < numChunks ) {
+            const char* split = std::max( p, adata + asize * (i+1) / numChunks );
+            const char* newline = (const char*)memchr( split, '\n', end - split );
+            p = newline ? newline+1 : end;
+        } else {
+            p = end;
+        }
+        chunks[i].end = p;
+    }
+
+    // a slot per line, lines that are not joint samples leave gaps that are closed below //
+    vector< size_t > numLines( numChunks );
+    parallelFor.run( numChunks, [&]( size_t abegin, size_t aend ) {
+        for( size_t i = abegin; i < aend; i++ ) {
+            numLines[i] = countLines( chunks[i].begin, chunks[i].end );
+        }
+    });
+    size_t totalLines = 0;
+    for( size_t i = 0; i < numChunks; i++ ) {
+        chunks[i].firstRecord = totalLines;
+        totalLines += numLines[i];
+    }
+    arecords.resize( totalLines );
+    if( !totalLines ) return;
+
+    SkeletonRecord* records = &arecords[0];
+    parallelFor.run( numChunks, [&]( size_t abegin, size_t aend ) {
+        for( size_t i = abegin; i < aend; i++ ) {
+            parseChunk( chunks[i], records + chunks[i].firstRecord );
+        }
+    });
+
+    // number the bodies by first appearance across the whole file //
+    map< string, uint32_t > bodyLookup;
+    for( auto& chunk : chunks ) {
+        chunk.remap.resize( chunk.bodies.size() );
+        for( size_t i = 0; i < chunk.bodies.size(); i++ ) {
+            string tbodyId( chunk.bodies[i].name, chunk.bodies[i].length );
+            auto it = bodyLookup.find( tbodyId );
+            if( it == bodyLookup.end() ) {
+                it = bodyLookup.insert( make_pair(tbodyId, (uint32_t)abodyIds.size()) ).first;
+                abodyIds.push_back( tbodyId );
+            }
+            chunk.remap[i] = it->second;
+        }
+    }
+    parallelFor.run( numChunks, [&]( size_t abegin, size_t aend ) {
+        for( size_t i = abegin; i < aend; i++ ) {
+            SkeletonRecord* trecords = records + chunks[i].firstRecord;
+            for( size_t r = 0; r < chunks[i].numRecords; r++ ) {
+                trecords[r].body = chunks[i].remap[ trecords[r].body ];
+            }
+        }
+    });
+
+    // chunks only move towards the front, so in order they never overwrite one another //
+    size_t numRecords = 0;
+    for( auto& chunk : chunks ) {
+        if( chunk.numRecords && chunk.firstRecord != numRecords ) {
+            memmove( records + numRecords, records + chunk.firstRecord, chunk.numRecords * sizeof(SkeletonRecord) );
+        }
+        numRecords += chunk.numRecords;
+    }
+    arecords.resize( numRecords );
+}
+
+//--------------------------------------------------------------
+bool SkeletonTextLoader::load( string atxtPath, vector<SkeletonRecord>& arecords, vector<string>& abodyIds, int anumThreads ) {
+    string fullPath = ofToDataPath( atxtPath, true );
+
+#ifndef TARGET_WIN32
+    int fd = open( fullPath.c_str(), O_RDONLY );
+    if( fd < 0 ) {
+        ofLogError("SkeletonTextLoader::load") << "could not open " << fullPath;
+        return false;
+    }
+    struct stat st;
+    if( fstat( fd, &st ) != 0 || st.st_size <= 0 ) {
+        ofLogError("SkeletonTextLoader::load") << "could not read " << fullPath;
+        ::close( fd );
+        return false;
+    }
+    size_t dataSize = (size_t)st.st_size;
+    void* tdata = mmap( nullptr, dataSize, PROT_READ, MAP_PRIVATE, fd, 0 );
+    ::close( fd );
+    if( tdata == MAP_FAILED ) {
+        ofLogError("SkeletonTextLoader::load") << "could not map " << fullPath;
+        return false;
+    }
+    madvise( tdata, dataSize, MADV_WILLNEED );
+    parse( (const char*)tdata, dataSize, arecords, abodyIds, anumThreads );
+    munmap( tdata, dataSize );
+#else
+    ofBuffer tbuffer = ofBufferFromFile( fullPath, true );
+    if( !tbuffer.size() ) {
+        ofLogError("SkeletonTextLoader::load") << "could not read " << fullPath;
+        return false;
+    }
+    parse( tbuffer.getData(), tbuffer.size(), arecords, abodyIds, anumThreads );
+#endif
+    return true;
+}
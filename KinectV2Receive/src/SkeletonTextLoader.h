@@ -0,0 +1,28 @@
+//
+//  SkeletonTextLoader.h
+//  KinectV2Receive
+//
+//  Parses legacy text recordings, one joint sample per line:
+//
+//      time|/bodies/{bodyId}/joints/{jointId}|fX|fY|fZ|sTrackingState
+//
+//  The file is split into a chunk per core at line boundaries and every chunk
+//  is parsed in place straight into the record array, so there are no strings
+//  per line or per field. Body ids are the only strings made, once per body.
+//  Lines that are not joint messages are skipped.
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SkeletonRecording.h"
+
+class SkeletonTextLoader {
+public:
+    // records are in file order, body indices in order of first appearance //
+    static bool load( string atxtPath, vector<SkeletonRecord>& arecords, vector<string>& abodyIds, int anumThreads = 0 );
+    // parses the text in [adata, adata + asize) //
+    static void parse( const char* adata, size_t asize, vector<SkeletonRecord>& arecords, vector<string>& abodyIds, int anumThreads = 0 );
+
+    // parses a decimal float such as -0.012054 or 1.5e-05 at aptr, false if there is none //
+    static bool parseFloat( const char*& aptr, const char* aend, float& avalue );
+};
@@ -0,0 +1,342 @@
+//
+//  SkeletonTrackCodec.cpp
+//  KinectV2Receive
+//
+
+#include "SkeletonTrackCodec.h"
+
+const float SkeletonTrackCodec::KEYFRAME_INTERVAL   = 1.f;
+const string SkeletonTrackCodec::FILE_EXTENSION     = "kskz";
+
+//--------------------------------------------------------------
+static inline uint64_t zigzag( int64_t avalue ) {
+    return ((uint64_t)avalue << 1) ^ (uint64_t)(avalue >> 63);
+}
+
+//--------------------------------------------------------------
+static inline int64_t unzigzag( uint64_t avalue ) {
+    return (int64_t)(avalue >> 1) ^ -(int64_t)(avalue & 1);
+}
+
+//--------------------------------------------------------------
+static inline void writeVarint( vector<char>& aout, uint64_t avalue ) {
+    while( avalue >= 0x80 ) {
+        aout.push_back( (char)(avalue | 0x80) );
+        avalue >>= 7;
+    }
+    aout.push_back( (char)avalue );
+}
+
+//--------------------------------------------------------------
+// false if the varint runs past aend or is longer than 64 bits //
+static inline bool readVarint( const uint8_t*& aptr, const uint8_t* aend, uint64_t& avalue ) {
+    if( aptr < aend && *aptr < 0x80 ) {
+        // most deltas fit in a byte //
+        avalue = *aptr++;
+        return true;
+    }
+    avalue = 0;
+    for( int shift = 0; shift < 64; shift += 7 ) {
+        if( aptr >= aend ) return false;
+        uint8_t tbyte = *aptr++;
+        avalue |= (uint64_t)(tbyte & 0x7f) << shift;
+        if( !(tbyte & 0x80) ) return true;
+    }
+    return false;
+}
+
+//--------------------------------------------------------------
+static inline int32_t quantize( double avalue, double ascale ) {
+    double tvalue = avalue * ascale;
+    // also catches nan //
+    if( !(tvalue > -1073741823.0 && tvalue < 1073741823.0) ) {
+        return 0;
+    }
+    return (int32_t)floor( tvalue + 0.5 );
+}
+
+//--------------------------------------------------------------
+static void encodeBlock( const SkeletonRecord* arecords, size_t anumRecords, vector<char>& aout ) {
+    // bodies are renumbered per block, so the state below stays small however long the take is //
+    // a body is only ever seen by one sensor, so it is stored once per body //
+    vector< uint32_t > bodies;
+    vector< uint8_t > sensors;
+    vector< uint32_t > localBodies( anumRecords );
+    for( size_t i = 0; i < anumRecords; i++ ) {
+        uint32_t tbody = arecords[i].body;
+        size_t local = 0;
+        while( local < bodies.size() && bodies[local] != tbody ) local++;
+        if( local == bodies.size() ) {
+            bodies.push_back( tbody );
+            sensors.push_back( arecords[i].sensor );
+        }
+        localBodies[i] = (uint32_t)local;
+    }
+    writeVarint( aout, (uint32_t)bodies.size() );
+    for( size_t i = 0; i < bodies.size(); i++ ) {
+        writeVarint( aout, bodies[i] );
+        aout.push_back( (char)sensors[i] );
+    }
+
+    vector< int32_t > previous( bodies.size() * Skeleton::TOTAL_JOINTS * 3, 0 );
+    int64_t prevTime = 0;
+    uint32_t prevBody = 0;
+    int prevJoint = -1;
+
+    for( size_t i = 0; i < anumRecords; i++ ) {
+        const SkeletonRecord& rec = arecords[i];
+        int joint = std::min( (int)rec.joint, Skeleton::TOTAL_JOINTS-1 );
+        int64_t ttime = (int64_t)floor( (double)rec.time * SkeletonTrackCodec::TIME_SCALE + 0.5 );
+        int64_t timeDelta = ttime - prevTime;
+
+        uint8_t control = rec.state & SkeletonTrackCodec::CONTROL_STATE_MASK;
+        if( timeDelta != 0 ) control |= SkeletonTrackCodec::CONTROL_TIME;
+        bool bJump = localBodies[i] != prevBody || joint != prevJoint+1;
+        if( bJump ) control |= SkeletonTrackCodec::CONTROL_JUMP;
+        aout.push_back( (char)control );
+
+        if( timeDelta != 0 ) {
+            writeVarint( aout, zigzag(timeDelta) );
+        }
+        if( bJump ) {
+            writeVarint( aout, localBodies[i] );
+            aout.push_back( (char)joint );
+        }
+
+        int32_t* prev = &previous[ (localBodies[i] * Skeleton::TOTAL_JOINTS + joint) * 3 ];
+        int32_t tpos[3] = {
+            quantize( rec.x, SkeletonTrackCodec::POSITION_SCALE ),
+            quantize( rec.y, SkeletonTrackCodec::POSITION_SCALE ),
+            quantize( rec.z, SkeletonTrackCodec::POSITION_SCALE )
+        };
+        for( int k = 0; k < 3; k++ ) {
+            writeVarint( aout, zigzag( (int64_t)tpos[k] - prev[k] ) );
+            prev[k] = tpos[k];
+        }
+
+        prevTime    = ttime;
+        prevBody    = localBodies[i];
+        prevJoint   = joint;
+    }
+}
+
+//--------------------------------------------------------------
+void SkeletonTrackCodec::encode( const SkeletonRecord* arecords, size_t anumRecords, const vector<string>& abodyIds, vector<char>& aout ) {
+    aout.assign( sizeof(SkeletonTrackHeader), 0 );
+    // the old text recordings take ~90 bytes per sample, this takes about 6 //
+    aout.reserve( sizeof(SkeletonTrackHeader) + anumRecords * 6 );
+
+    vector< SkeletonTrackBlock > blocks;
+    size_t start = 0;
+    while( start < anumRecords ) {
+        float blockEnd = arecords[start].time + KEYFRAME_INTERVAL;
+        size_t end = start+1;
+        while( end < anumRecords && arecords[end].time < blockEnd ) {
+            end++;
+        }
+
+        SkeletonTrackBlock tblock;
+        memset( &tblock, 0, sizeof(tblock) );
+        tblock.offset       = aout.size();
+        tblock.firstRecord  = start;
+        tblock.numRecords   = (uint32_t)(end - start);
+        tblock.startTime    = arecords[start].time;
+        encodeBlock( arecords + start, end - start, aout );
+        tblock.size         = (uint32_t)(aout.size() - tblock.offset);
+        blocks.push_back( tblock );
+        start = end;
+    }
+
+    SkeletonTrackHeader header;
+    memset( &header, 0, sizeof(header) );
+    memcpy( header.magic, "KSKZ", 4 );
+    header.version          = VERSION;
+    header.positionScale    = POSITION_SCALE;
+    header.timeScale        = TIME_SCALE;
+    header.numJointNames    = Skeleton::TOTAL_JOINTS;
+    header.numBodyIds       = (uint32_t)abodyIds.size();
+    header.numBlocks        = (uint32_t)blocks.size();
+    header.numRecords       = anumRecords;
+    header.blockIndexOffset = aout.size();
+    header.stringTableOffset = header.blockIndexOffset + blocks.size() * sizeof(SkeletonTrackBlock);
+    header.duration         = anumRecords ? arecords[anumRecords-1].time : 0.f;
+
+    if( blocks.size() ) {
+        const char* tblocks = (const char*)&blocks[0];
+        aout.insert( aout.end(), tblocks, tblocks + blocks.size() * sizeof(SkeletonTrackBlock) );
+    }
+    ostringstream tstrings;
+    SkeletonRecording::writeStringTable( tstrings, abodyIds );
+    string tstr = tstrings.str();
+    aout.insert( aout.end(), tstr.begin(), tstr.end() );
+    memcpy( &aout[0], &header, sizeof(header) );
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackCodec::save( string afilePath, const SkeletonRecord* arecords, size_t anumRecords, const vector<string>& abodyIds ) {
+    vector< char > tdata;
+    encode( arecords, anumRecords, abodyIds, tdata );
+
+    ofstream fout( ofToDataPath(afilePath, true).c_str(), ios::binary | ios::trunc );
+    if( !fout ) {
+        ofLogError("SkeletonTrackCodec::save") << "could not open " << afilePath << " for writing";
+        return false;
+    }
+    fout.write( &tdata[0], tdata.size() );
+    return fout.good();
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackCodec::compress( string ainPath, string aoutPath ) {
+    if( ofFilePath::getFileExt(ainPath) == FILE_EXTENSION ) {
+        ofLogWarning("SkeletonTrackCodec::compress") << ainPath << " is already compressed";
+        return false;
+    }
+    // .txt recordings are converted to a .kskel on the way //
+    SkeletonRecording trecording;
+    if( !trecording.load( ainPath ) ) {
+        return false;
+    }
+    if( !save( aoutPath, trecording.getRecords(), trecording.getNumRecords(), trecording.getBodyIds() ) ) {
+        return false;
+    }
+
+    uint64_t inSize = ofFile( ainPath ).getSize();
+    uint64_t outSize = ofFile( aoutPath ).getSize();
+    ofLogNotice("SkeletonTrackCodec") << "compressed " << trecording.getNumRecords() << " records from " << ainPath << " to " << aoutPath << ", "
+        << inSize << " -> " << outSize << " bytes (" << ofToString( outSize ? (double)inSize / outSize : 0., 1 ) << "x)";
+    return true;
+}
+
+//--------------------------------------------------------------
+string SkeletonTrackCodec::getCompressedPath( string apath ) {
+    return ofFilePath::removeExt( apath ) + "." + FILE_EXTENSION;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackCodec::isCompressed( const char* adata, size_t asize ) {
+    return asize >= 4 && memcmp( adata, "KSKZ", 4 ) == 0;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackDecoder::open( const char* adata, size_t asize ) {
+    data = adata;
+    dataSize = asize;
+    blocks.clear();
+    bodyIds.clear();
+
+    if( asize < sizeof(SkeletonTrackHeader) || !SkeletonTrackCodec::isCompressed( adata, asize ) ) {
+        return false;
+    }
+    memcpy( &header, adata, sizeof(header) );
+    if( header.version < SkeletonTrackCodec::MIN_VERSION || header.version > SkeletonTrackCodec::VERSION ) {
+        ofLogError("SkeletonTrackDecoder") << "unsupported compressed recording version " << header.version;
+        return false;
+    }
+    if( header.positionScale == 0 || header.timeScale == 0 ) {
+        return false;
+    }
+
+    uint64_t indexSize = (uint64_t)header.numBlocks * sizeof(SkeletonTrackBlock);
+    if( header.blockIndexOffset < sizeof(SkeletonTrackHeader) || header.blockIndexOffset + indexSize > header.stringTableOffset || header.stringTableOffset > asize ) {
+        return false;
+    }
+    blocks.resize( header.numBlocks );
+    if( indexSize ) {
+        memcpy( &blocks[0], adata + header.blockIndexOffset, (size_t)indexSize );
+    }
+
+    uint64_t numRecords = 0;
+    for( auto& tblock : blocks ) {
+        if( tblock.firstRecord != numRecords || tblock.offset < sizeof(SkeletonTrackHeader) || tblock.offset + tblock.size > header.blockIndexOffset ) {
+            return false;
+        }
+        numRecords += tblock.numRecords;
+    }
+    if( numRecords != header.numRecords ) {
+        return false;
+    }
+    return SkeletonRecording::readStringTable( adata, asize, header.stringTableOffset, header.numJointNames, header.numBodyIds, bodyIds );
+}
+
+//--------------------------------------------------------------
+size_t SkeletonTrackDecoder::findBlock( float atime ) const {
+    auto it = upper_bound( blocks.begin(), blocks.end(), atime, []( float t, const SkeletonTrackBlock& ablock ) {
+        return t < ablock.startTime;
+    });
+    return it == blocks.begin() ? 0 : (it - blocks.begin()) - 1;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackDecoder::decodeBlock( size_t aindex, SkeletonRecord* aout ) {
+    const SkeletonTrackBlock& tblock = blocks[aindex];
+    const uint8_t* ptr = (const uint8_t*)data + tblock.offset;
+    const uint8_t* end = ptr + tblock.size;
+
+    uint64_t tvalue = 0;
+    if( !readVarint( ptr, end, tvalue ) || tvalue > tblock.numRecords ) return false;
+    uint32_t numBodies = (uint32_t)tvalue;
+    blockBodies.resize( numBodies );
+    blockSensors.assign( numBodies, 0 );
+    for( uint32_t i = 0; i < numBodies; i++ ) {
+        if( !readVarint( ptr, end, tvalue ) || tvalue > UINT_MAX ) return false;
+        blockBodies[i] = (uint32_t)tvalue;
+        if( header.version >= 2 ) {
+            if( ptr >= end ) return false;
+            blockSensors[i] = *ptr++;
+        }
+    }
+    previous.assign( numBodies * Skeleton::TOTAL_JOINTS * 3, 0 );
+
+    double timeScale = 1.0 / header.timeScale;
+    float positionScale = 1.f / header.positionScale;
+    int64_t ttime = 0;
+    uint64_t body = 0;
+    int joint = -1;
+
+    for( uint32_t i = 0; i < tblock.numRecords; i++ ) {
+        if( ptr >= end ) return false;
+        uint8_t control = *ptr++;
+        if( control & SkeletonTrackCodec::CONTROL_TIME ) {
+            if( !readVarint( ptr, end, tvalue ) ) return false;
+            ttime += unzigzag( tvalue );
+        }
+        if( control & SkeletonTrackCodec::CONTROL_JUMP ) {
+            if( !readVarint( ptr, end, body ) || ptr >= end ) return false;
+            joint = *ptr++;
+        } else {
+            joint++;
+        }
+        if( body >= numBodies || joint >= Skeleton::TOTAL_JOINTS ) return false;
+
+        int32_t* prev = &previous[ ((size_t)body * Skeleton::TOTAL_JOINTS + joint) * 3 ];
+        for( int k = 0; k < 3; k++ ) {
+            if( !readVarint( ptr, end, tvalue ) ) return false;
+            prev[k] += (int32_t)unzigzag( tvalue );
+        }
+
+        SkeletonRecord& rec = aout[i];
+        rec.time        = (float)(ttime * timeScale);
+        rec.x           = prev[0] * positionScale;
+        rec.y           = prev[1] * positionScale;
+        rec.z           = prev[2] * positionScale;
+        rec.body        = blockBodies[(size_t)body];
+        rec.joint       = (uint8_t)joint;
+        rec.state       = control & SkeletonTrackCodec::CONTROL_STATE_MASK;
+        rec.sensor      = blockSensors[(size_t)body];
+        rec.reserved    = 0;
+    }
+    return true;
+}
+
+//--------------------------------------------------------------
+bool SkeletonTrackDecoder::decodeAll( vector<SkeletonRecord>& aout ) {
+    aout.resize( (size_t)header.numRecords );
+    for( size_t i = 0; i < blocks.size(); i++ ) {
+        if( blocks[i].numRecords && !decodeBlock( i, &aout[ (size_t)blocks[i].firstRecord ] ) ) {
+            aout.clear();
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,122 @@
+//
+//  SkeletonTrackCodec.h
+//  KinectV2Receive
+//
+//  Compressed skeleton recordings for archiving, about a quarter of the size of
+//  a .kskel and a sixteenth of the old text recordings. SkeletonRecording::load
+//  decodes them, so they play like any other recording.
+//
+//  Positions are quantized to 0.1 mm and times to microseconds. Records are
+//  grouped into blocks of KEYFRAME_INTERVAL seconds. The first sample of a joint
+//  in a block is stored in full, the following ones as the difference to the
+//  previous sample of the same joint, so every block decodes on its own and
+//  seeking only needs the block index.
+//
+//  Every record starts with a control byte:
+//      bits 0-1    Skeleton::TrackingState
+//      bit 2       a zigzag varint time delta follows, otherwise same time as
+//                  the previous record
+//      bit 3       a varint block body index and a joint byte follow, otherwise
+//                  same body as the previous record and the next joint
+//  followed by the zigzag varint x, y and z deltas.
+//
+//  File layout (little endian), version 2:
+//      SkeletonTrackHeader         64 bytes
+//      blocks                      varint number of bodies in the block, their
+//                                  varint body id indices each followed by the
+//                                  sensor byte, then the records
+//      SkeletonTrackBlock[]        numBlocks, the block index
+//      string table                as in SkeletonRecording
+//
+
+#pragma once
+#include "ofMain.h"
+#include "SkeletonRecording.h"
+
+#pragma pack(push, 1)
+struct SkeletonTrackHeader {
+    char magic[4];              // "KSKZ"
+    uint16_t version;
+    uint16_t reserved0;
+    uint32_t flags;
+    uint32_t positionScale;     // quantization steps per meter
+    uint32_t timeScale;         // quantization steps per second
+    uint32_t numJointNames;
+    uint32_t numBodyIds;
+    uint32_t numBlocks;
+    uint64_t numRecords;
+    uint64_t blockIndexOffset;
+    uint64_t stringTableOffset;
+    float duration;
+    uint8_t reserved[4];
+};
+
+struct SkeletonTrackBlock {
+    uint64_t offset;            // from the start of the file
+    uint64_t firstRecord;
+    uint32_t size;              // bytes
+    uint32_t numRecords;
+    float startTime;
+    uint32_t reserved;
+};
+#pragma pack(pop)
+
+static_assert( sizeof(SkeletonTrackHeader) == 64, "SkeletonTrackHeader must be 64 bytes" );
+static_assert( sizeof(SkeletonTrackBlock) == 32, "SkeletonTrackBlock must be 32 bytes" );
+
+class SkeletonTrackCodec {
+public:
+    static const uint16_t VERSION = 2;
+    // version 1 has no sensor bytes, its records decode as sensor 0 //
+    static const uint16_t MIN_VERSION = 1;
+    static const uint32_t POSITION_SCALE = 10000;
+    static const uint32_t TIME_SCALE = 1000000;
+    static const float KEYFRAME_INTERVAL;
+    static const string FILE_EXTENSION;
+
+    enum ControlBits {
+        CONTROL_STATE_MASK  = 0x03,
+        CONTROL_TIME        = 0x04,
+        CONTROL_JUMP        = 0x08
+    };
+
+    // arecords have to be sorted by time, as in every SkeletonRecording //
+    static void encode( const SkeletonRecord* arecords, size_t anumRecords, const vector<string>& abodyIds, vector<char>& aout );
+    static bool save( string afilePath, const SkeletonRecord* arecords, size_t anumRecords, const vector<string>& abodyIds );
+    // compresses a .kskel or .txt recording //
+    static bool compress( string ainPath, string aoutPath );
+    static string getCompressedPath( string apath );
+
+    static bool isCompressed( const char* adata, size_t asize );
+};
+
+// reads a compressed recording from memory, a block at a time //
+class SkeletonTrackDecoder {
+public:
+    // checks the header, block index and string table, nothing is decoded yet //
+    bool open( const char* adata, size_t asize );
+
+    size_t getNumBlocks() const { return blocks.size(); }
+    const SkeletonTrackBlock& getBlock( size_t aindex ) const { return blocks[aindex]; }
+    // index of the block holding atime //
+    size_t findBlock( float atime ) const;
+    uint64_t getNumRecords() const { return header.numRecords; }
+    float getDuration() const { return header.duration; }
+    const vector< string >& getBodyIds() const { return bodyIds; }
+
+    // writes getBlock( aindex ).numRecords records to aout, false if the block is corrupt //
+    bool decodeBlock( size_t aindex, SkeletonRecord* aout );
+    bool decodeAll( vector<SkeletonRecord>& aout );
+
+protected:
+    const char* data = nullptr;
+    size_t dataSize = 0;
+    SkeletonTrackHeader header;
+    vector< SkeletonTrackBlock > blocks;
+    vector< string > bodyIds;
+
+    // reused between blocks //
+    vector< uint32_t > blockBodies;
+    vector< uint8_t > blockSensors;
+    vector< int32_t > previous;
+};
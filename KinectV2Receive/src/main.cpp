@@ -1,9 +1,33 @@
 #include "ofMain.h"
 #include "ofApp.h"
+#include "ReplayBenchmark.h"
+#include "SkeletonTrackCodec.h"
 
 //========================================================================
-int main( ){
-	ofSetupOpenGL(1200,768,OF_WINDOW);			// <-------- setup the GL context
+int main( int argc, char* argv[] ){
+	// --bench replays a recording through the pipeline without a window, see ReplayBenchmark.h //
+	ReplayBenchmark::Settings benchSettings;
+	if( ReplayBenchmark::parseArgs( argc, argv, benchSettings ) ) {
+		return ReplayBenchmark::run( benchSettings );
+	}
+	// --compress writes a .kskz next to every recording given, for archiving //
+	if( argc > 2 && string( argv[1] ) == "--compress" ) {
+		int numFailed = 0;
+		for( int i = 2; i < argc; i++ ) {
+			if( !SkeletonTrackCodec::compress( argv[i], SkeletonTrackCodec::getCompressedPath( argv[i] ) ) ) {
+				numFailed++;
+			}
+		}
+		return numFailed ? 1 : 0;
+	}
+
+	// the programmable renderer lets the particles draw instanced //
+	ofGLWindowSettings settings;
+	settings.setGLVersion( 3, 2 );
+	settings.width = 1200;
+	settings.height = 768;
+	settings.windowMode = OF_WINDOW;
+	ofCreateWindow( settings );			// <-------- setup the GL context
 
 	// this kicks off the running of my app
 	// can be OF_WINDOW or OF_FULLSCREEN
@@ -1,4 +1,5 @@
 #include "ofApp.h"
+#include "Benchmarks.h"
 /*
 Address: /bodies/{bodyId}/joints/{jointId}
 Values: 
@@ -14,34 +15,61 @@ Values:
 
 */
 
-//--------------------------------------------------------------
-bool ofApp::shouldRemoveParticle( const Particle& p ) {
-    return p.bRemove;
-}
-
 //--------------------------------------------------------------
 void ofApp::setup() {
+    // before any other thread is started, so the profiler shows this one as main //
+    FrameProfiler::get().registerMainThread();
     ofSetFrameRate( 60 );
     
+    particles.allocate( 200000 );
+    particleRenderer.setup( particles.getCapacity() );
     
     bUseLiveOsc = false;
     // uncomment to use OSC //
     if(bUseLiveOsc) {
-        oscRX.setup( 12345 );
+        // one receiver thread per sensor, calibrated into the room by sensors.xml //
+        sensors = SensorCalibration::load( "sensors.xml" );
+        if( sensors.empty() ) {
+            sensors.push_back( SensorCalibration() );
+        }
+        for( size_t i = 0; i < sensors.size(); i++ ) {
+            oscReceivers.push_back( unique_ptr<SkeletonOscReceiver>( new SkeletonOscReceiver() ) );
+            oscReceivers.back()->setup( sensors[i].port, (uint32_t)i );
+        }
     }
     
-    ofDirectory tdir;
-    tdir.allowExt("txt");
-    tdir.listDir("recordings");
-    if( tdir.size() ) {
-        loadPlaybackData( tdir.getPath( tdir.size()-1 ));
+    if( frameRelay.load( "relay.xml" ) ) {
+        frameRelay.start();
     }
     
+    player.onRecord = [this]( const SkeletonRecord& rec ) {
+        // recorded in the room frame, keyed by sensor so multi sensor takes fuse as they did live //
+        updateJoint( SkeletonTable::makeKey(rec.sensor, rec.body), (Skeleton::JointIndex)rec.joint, ofVec3f(rec.x, rec.y, rec.z), (Skeleton::TrackingState)rec.state );
+    };
+    
+    // the newest recording is loaded once the list is in, see updatePlaybackLoading() //
+    playbackRecording.reset( new SkeletonRecording() );
+    recordingList = std::async( std::launch::async, []() {
+        return SkeletonRecording::list( "recordings" );
+    });
+    
     
     gui.setup("Image Processing");
     gui.setPosition(ofGetWidth()-10-gui.getWidth(), 10 );
     gui.add(bDebug.set("Debug", true ));
+    gui.add(maxParticles.set("MaxParticles", 2000, 0, 200000 ));
+    gui.add(bFilter.set("Filter", true ));
+    gui.add(filterMinCutoff.set("FilterMinCutoff", skeletonFilter.minCutoff, 0.05, 10 ));
+    gui.add(filterBeta.set("FilterBeta", skeletonFilter.beta, 0, 0.05 ));
     if(bUseLiveOsc) gui.add(bRecording.set("Recording", false ));
+    if(!bUseLiveOsc) {
+        gui.add(playbackPosition.set("PlaybackPosition", 0, 0, 0.01f ));
+        gui.add(playbackSpeed.set("PlaybackSpeed", 1, SkeletonPlayer::MIN_SPEED, SkeletonPlayer::MAX_SPEED ));
+        gui.add(bPlaybackReverse.set("PlaybackReverse", false ));
+        gui.add(bPlaybackLoop.set("PlaybackLoop", true ));
+        gui.add(bPlaybackPaused.set("PlaybackPaused", false ));
+        gui.add(playbackInterpolation.set("PlaybackInterpolation", SkeletonPlayer::INTERPOLATION_LINEAR, SkeletonPlayer::INTERPOLATION_NONE, SkeletonPlayer::INTERPOLATION_CUBIC ));
+    }
     
     
     
@@ -57,175 +85,239 @@ void ofApp::setup() {
 
 //--------------------------------------------------------------
 void ofApp::update() {
+    FrameProfiler::get().beginFrame();
+    PROFILE_SCOPE( "update" );
     
     float etimef = ofGetElapsedTimef();
     
-    for( auto it = skeletons.begin(); it != skeletons.end(); it++ ) {
-        for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
-            it->second->getJoint( (Skeleton::JointIndex)i )->prevPos = it->second->getJoint( (Skeleton::JointIndex)i )->pos;
-        }
+    updateTime = etimef;
+    for( size_t i = 0; i < skeletons.size(); i++ ) {
+        skeletons.getSkeleton(i).clearNewFrame();
     }
+    for( size_t i = 0; i < fusedSkeletons.size(); i++ ) {
+        fusedSkeletons.getSkeleton(i).clearNewFrame();
+    }
+    
     
+    // also feeds the stand-in sensors //
+    updatePlaybackLoading();
     
     if( bUseLiveOsc ) {
-        while( oscRX.hasWaitingMessages() ){
-            ofxOscMessage msg;
-            oscRX.getNextMessage(msg);
-            
-            parseMessage( msg );
-            
-            if( bRecording ) {
-                if( uniqueFilename == "" ) {
-                    uniqueFilename = ofGetTimestampString();
-                    startRecordingTime = etimef;
-                    recordingData.clear();
-                }
-            } else {
-                // save the file //
-                if( uniqueFilename != "" ) {
-                    saveRecording();
-                }
-                
-                recordingData.clear();
-                uniqueFilename = "";
+        if( bRecording ) {
+            if( uniqueFilename == "" ) {
+                uniqueFilename = ofGetTimestampString();
+                startRecordingTime = etimef;
+                startRecording();
             }
-            
-            if( bRecording ) {
-                SkeletonData sdata;
-                sdata.time = etimef - startRecordingTime;
-                sdata.message = msg;
-                recordingData.push_back( sdata );
+        } else {
+            // save the file //
+            if( uniqueFilename != "" ) {
+                saveRecording();
             }
             
-        }
-    } else {
-        if( playbackData.size() == 0 && playbackDataCached.size() ) {
-            playbackData = playbackDataCached;
-            playbackTimeStart = etimef;
+            uniqueFilename = "";
         }
         
-        if( playbackData.size() ) {
-            float playEndTime = playbackTimeStart + playbackData.back().time;
-            float timeSinceStart = etimef - playbackTimeStart;
-            int numToKill=0;
-            for( int k = 0; k < playbackData.size(); k++ ) {
-                if( playbackData[k].time <= timeSinceStart ) {
-                    parseMessage( playbackData[k].message );
-                    numToKill++;
-                } else {
-                    break;
-                }
-            }
-            if( numToKill > 0 ) {
-                playbackData.erase( playbackData.begin(), playbackData.begin()+numToKill );
+        // destroyed once their file is finalized, so the join does not wait //
+        for( size_t i = 0; i < retiredWriters.size(); ) {
+            if( retiredWriters[i]->isFinished() ) {
+                retiredWriters[i] = std::move( retiredWriters.back() );
+                retiredWriters.pop_back();
+            } else {
+                i++;
             }
         }
         
+        // everything the receive threads decoded since the last frame, merged into arrival //
+        // order across sensors, recordings have to be sorted by time //
+        PROFILE_SCOPE( "osc samples" );
+        mergedSamples.clear();
+        for( auto& receiver : oscReceivers ) {
+            receiver->consume( jointSamples );
+            size_t numMerged = mergedSamples.size();
+            mergedSamples.insert( mergedSamples.end(), jointSamples.begin(), jointSamples.end() );
+            std::inplace_merge( mergedSamples.begin(), mergedSamples.begin() + numMerged, mergedSamples.end(), []( const SkeletonJointSample& a, const SkeletonJointSample& b ) {
+                return a.arrivalMicros < b.arrivalMicros;
+            });
+        }
+        for( auto& sample : mergedSamples ) {
+            processJointSample( sample );
+        }
+        // also written while nobody is in view //
+        if( recordingWriter ) {
+            recordingWriter->flushIfDue( etimef - startRecordingTime );
+        }
+    } else {
+        PROFILE_SCOPE( "playback" );
+        player.setSpeed( playbackSpeed );
+        player.setReverse( bPlaybackReverse );
+        player.setLoop( bPlaybackLoop );
+        player.setPaused( bPlaybackPaused );
+        player.setInterpolation( (SkeletonPlayer::Interpolation)playbackInterpolation.get() );
         
-    }
-    
-    // clean up old skeletons //
-    for( auto it = skeletons.begin(); it != skeletons.end(); it++ ) {
-        if(etimef - it->second->lastTimeSeen > 2.0 ) {
-            skeletons.erase( it );
-            break;
+        if( playbackPosition != lastPlaybackPosition ) {
+            player.seek( playbackPosition );
+        } else {
+            player.update( ofGetLastFrameTime() );
         }
+        playbackPosition = player.getTime();
+        lastPlaybackPosition = playbackPosition;
     }
     
-    // if there are skeletons, add some particles //
-    if( skeletons.size() ) {
-        for( auto it = skeletons.begin(); it != skeletons.end(); it++ ) {
-            // get random joint index //
-//            int rindex = ofRandom(0, Skeleton::TOTAL_JOINTS );
-//            if( rindex == Skeleton::TOTAL_JOINTS ) rindex = Skeleton::TOTAL_JOINTS-1;
-            
-            for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
-                Particle p;
-                shared_ptr< Skeleton::Joint > joint = it->second->getJoint( (Skeleton::JointIndex)i );
-                p.pos = joint->pos;
-                p.vel = (joint->pos - joint->prevPos);// * 3.0;
-                p.vel.limit(50);
-                p.size = ofRandom( 14, 26 );
-                particles.push_back( p );
-            }
-        }
+    {
+        PROFILE_SCOPE( "skeletons" );
+        // clean up old skeletons //
+        skeletons.reapExpired( etimef );
+        fusion.update( skeletons, fusedSkeletons );
+        fusedSkeletons.reapExpired( etimef );
+        
+        skeletonFilter.bEnabled = bFilter;
+        skeletonFilter.minCutoff = filterMinCutoff;
+        skeletonFilter.beta = filterBeta;
+        skeletonFilter.update( fusedSkeletons );
+    }
+    {
+        PROFILE_SCOPE( "relay" );
+        frameRelay.publish( fusedSkeletons, etimef );
     }
     
-    for( int i = 0; i < particles.size(); i++ ) {
-        // gravity
-        particles[i].vel *= 0.94f;
-        particles[i].vel.y -= 0.02;
-        particles[i].pos += particles[i].vel;
+    {
+        PROFILE_SCOPE( "particles" );
+        // if there are skeletons, add some particles //
+        spawnParticles( fusedSkeletons, particles );
         
-        particles[i].size -= (1.f/60.f)/0.08f;
-        
-        if( particles[i].pos.y < -1000 || particles[i].size < 0.1 ) {
-            particles[i].bRemove = true;
-        }
+        particles.setMaxParticles( maxParticles );
+        particles.update();
     }
-    
-    int tooMany = particles.size()-2000;
-    if( tooMany > 0 ) {
-        for( int i = 0; i < tooMany; i++ ) {
-            particles[i].bRemove = true;
-        }
+    {
+        PROFILE_SCOPE( "particle buffer" );
+        particleRenderer.update( particles );
     }
     
-    ofRemove( particles, shouldRemoveParticle );
-    
 //    cout << "Number of skeletons : " << skeletons.size() << " | " << ofGetFrameNum() << endl;
     
 }
 
 //--------------------------------------------------------------
-void ofApp::parseMessage( ofxOscMessage amsg ) {
+void ofApp::updatePlaybackLoading() {
+    if( recordingList.valid() && recordingList.wait_for( std::chrono::seconds(0) ) == std::future_status::ready ) {
+        recordingPaths = recordingList.get();
+        if( recordingPaths.size() ) {
+            // named by timestamp, so the last one is the newest //
+            recordingIndex = (int)recordingPaths.size()-1;
+            loadPlaybackData( recordingPaths[recordingIndex] );
+        }
+    }
     
-//    cout << "msg: " << amsg.getAddress() << " | " << ofGetFrameNum() << endl;
+    if( pendingRecording ) {
+        if( pendingRecording->isLoaded() ) {
+            switchPlaybackRecording();
+        } else if( pendingRecording->hasFailed() ) {
+            ofLogError("ofApp") << "could not load " << pendingRecording->getPath();
+            retireRecording( std::move(pendingRecording) );
+        }
+    }
     
-    string address = amsg.getAddress();
-    if( address.size() > 0 && address[0] == '/' ) {
-        address = address.substr( 1, address.size()-1 );
+    // destroyed once their loading thread is done, so the join does not wait //
+    for( size_t i = 0; i < retiredRecordings.size(); ) {
+        if( !retiredRecordings[i]->isLoading() ) {
+            retiredRecordings[i] = std::move( retiredRecordings.back() );
+            retiredRecordings.pop_back();
+        } else {
+            i++;
+        }
     }
-    vector< string > parts = split( address, '/' );
+}
+
+//--------------------------------------------------------------
+void ofApp::switchPlaybackRecording() {
+    // body indices are per recording //
+    standInSenders.clear();
+    skeletons.clear();
+    fusedSkeletons.clear();
+    retireRecording( std::move(playbackRecording) );
+    playbackRecording = std::move( pendingRecording );
     
-    if( parts.size() >= 4 ) {
-        string bodyId = parts[1];
-        string typeName = parts[2];
-        if( typeName == "joints") {
-            
-            ofVec3f tpos;
-            tpos.x = amsg.getArgAsFloat(0);
-            tpos.y = amsg.getArgAsFloat(1);
-            tpos.z = amsg.getArgAsFloat(2);
-            
-            string status = amsg.getArgAsString(3);
-            bool bSeen = (status != "NotTracked" && status != "Unknown");
-            
-            string jointName = parts[ 3 ];
+    cout << "Playing " << playbackRecording->getPath() << ", " << playbackRecording->getTotalRecords() << " records" << endl;
+    player.setup( playbackRecording.get() );
+    playbackPosition.setMax( std::max(playbackRecording->getDuration(), 0.01f) );
+    playbackPosition = 0;
+    lastPlaybackPosition = 0;
+    
+    if( bUseLiveOsc && bStandInSensors ) {
+        for( auto& sensor : sensors ) {
+            standInSenders.push_back( unique_ptr<SkeletonOscSender>( new SkeletonOscSender() ) );
+            standInSenders.back()->setup( playbackRecording.get(), "127.0.0.1", sensor );
+        }
+    }
+}
+
+//--------------------------------------------------------------
+void ofApp::retireRecording( unique_ptr<SkeletonRecording> arecording ) {
+    if( !arecording ) return;
+    arecording->cancelLoad();
+    retiredRecordings.push_back( std::move(arecording) );
+}
+
+//--------------------------------------------------------------
+void ofApp::spawnParticles( SkeletonTable& askeletons, ParticleSystem& aparticles ) {
+    if( askeletons.size() ) {
+        for( size_t s = 0; s < askeletons.size(); s++ ) {
+            const Skeleton& skeleton = askeletons.getSkeleton(s);
+            // get random joint index //
+//            int rindex = ofRandom(0, Skeleton::TOTAL_JOINTS );
+//            if( rindex == Skeleton::TOTAL_JOINTS ) rindex = Skeleton::TOTAL_JOINTS-1;
             
-            if( !skeletons.count(bodyId)) {
-                skeletons[bodyId] = shared_ptr<Skeleton>(new Skeleton() );
-                skeletons[bodyId]->build();
+            for( int i = 0; i < Skeleton::TOTAL_JOINTS; i++ ) {
+                const ofVec3f& jointPos = skeleton.getPosition( (Skeleton::JointIndex)i );
+                ofVec3f vel;
+                // skeletons only move when a frame was published this update //
+                if( skeleton.hasNewFrame() ) {
+                    vel = (jointPos - skeleton.getPreviousPosition( (Skeleton::JointIndex)i ));// * 3.0;
+                }
+                vel.limit(50);
+                aparticles.spawn( jointPos, vel, ofRandom( 14, 26 ) );
             }
-            skeletons[bodyId]->addOrUpdateJoint( jointName, tpos, bSeen );
         }
     }
+}
+
+//--------------------------------------------------------------
+void ofApp::processJointSample( const SkeletonJointSample& asample ) {
+    ofVec3f tpos = sensors[asample.sensor].apply( asample.pos );
+    if( recordingWriter ) {
+        float sampleTime = asample.arrivalMicros / 1000000.0 - startRecordingTime;
+        recordingWriter->add( sampleTime, asample.sensor, oscReceivers[asample.sensor]->getBodyId( asample.body ), asample.joint, tpos, asample.state );
+    }
     
+    updateJoint( SkeletonTable::makeKey(asample.sensor, asample.body), asample.joint, tpos, asample.state );
+}
+
+//--------------------------------------------------------------
+void ofApp::updateJoint( uint64_t abodyKey, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate ) {
+    skeletons.get( skeletons.acquire(abodyKey, updateTime) )->addJointSample( ajoint, apos, astate, updateTime );
 }
 
 //--------------------------------------------------------------
 void ofApp::draw() {
+    PROFILE_SCOPE( "draw" );
     
     cam.begin(); {
         ofEnableDepthTest();
         ofSetColor( 120 );
-        for( auto it = skeletons.begin(); it != skeletons.end(); it++ ) {
-            it->second->draw();
+        skeletonRenderer.begin();
+        for( size_t i = 0; i < fusedSkeletons.size(); i++ ) {
+            skeletonRenderer.add( fusedSkeletons.getSkeleton(i) );
+        }
+        {
+            PROFILE_SCOPE( "draw skeletons" );
+            skeletonRenderer.draw();
         }
         
         ofSetColor( 55 );
-        for( int i = 0; i < particles.size(); i++ ) {
-            ofDrawSphere( particles[i].pos, particles[i].size );
+        {
+            PROFILE_SCOPE( "draw particles" );
+            particleRenderer.draw();
         }
         
         ofDrawGrid( 1000, 10, false, false, true, false );
@@ -234,87 +326,77 @@ void ofApp::draw() {
     
     if( !bHide ){
         gui.draw();
+        
+        stringstream relayInfo;
+        if( bDebug ) {
+            for( auto& stats : frameRelay.getStats() ) {
+                relayInfo << endl << "relay " << stats.host << ":" << stats.port << endl;
+                relayInfo << "  sent: " << stats.numSent << " dropped: " << stats.numDropped << endl;
+                relayInfo << "  queue depth: " << stats.queueDepth << " max: " << stats.maxQueueDepth;
+            }
+        }
+        
+        if( bDebug && bUseLiveOsc ) {
+            stringstream ss;
+            for( auto& receiver : oscReceivers ) {
+                SkeletonOscReceiver::Stats stats = receiver->getStats();
+                ss << "port " << receiver->getPort() << endl;
+                ss << "  osc received: " << stats.numReceived << endl;
+                ss << "  queue depth: " << stats.queueDepth << endl;
+                ss << "  dropped: " << stats.numDropped << " malformed: " << stats.numMalformed << endl;
+                ss << "  latency avg: " << ofToString(stats.latencyAvgMs, 2) << "ms max: " << ofToString(stats.latencyMaxMs, 2) << "ms" << endl;
+            }
+            ss << "sensor bodies: " << skeletons.size() << " fused: " << fusedSkeletons.size();
+            ss << relayInfo.str();
+            ofDrawBitmapStringHighlight( ss.str(), gui.getPosition().x, gui.getPosition().y + gui.getHeight() + 20 );
+        } else if( bDebug ) {
+            stringstream ss;
+            ss << ofFilePath::getFileName( playbackRecording->getPath() );
+            if( playbackRecording->isLoaded() && !playbackRecording->isComplete() ) {
+                ss << " " << (int)(playbackRecording->getLoadProgress() * 100.f) << "%";
+            }
+            if( pendingRecording ) {
+                ss << endl << "loading " << ofFilePath::getFileName( pendingRecording->getPath() );
+            }
+            ss << endl << "[ ] to switch recordings";
+            ss << relayInfo.str();
+            ofDrawBitmapStringHighlight( ss.str(), gui.getPosition().x, gui.getPosition().y + gui.getHeight() + 20 );
+        }
+        if( FrameProfiler::isEnabled() ) {
+            FrameProfiler::get().draw( gui.getPosition().x - 360, gui.getPosition().y + 10 );
+        }
     }
 }
 
 //--------------------------------------------------------------
-void ofApp::saveRecording() {
-    cout << "Saving recording to " << uniqueFilename << endl;
+void ofApp::startRecording() {
+    string tpath = "recordings/"+uniqueFilename+"."+SkeletonRecording::FILE_EXTENSION;
+    cout << "Recording to " << tpath << endl;
     if( !ofDirectory::doesDirectoryExist("recordings/")) {
         ofDirectory::createDirectory("recordings/");
     }
     
-    ofBuffer buffer;
-    for( auto a : recordingData ){
-        
-        buffer.append( ofToString(a.time)+"|" );
-        buffer.append( a.message.getAddress() );
-        
-        for( int i = 0; i < a.message.getNumArgs(); i++ ) {
-            buffer.append("|");
-            if( a.message.getArgType(i) == OFXOSC_TYPE_FLOAT ) {
-                buffer.append( "f"+ofToString(a.message.getArgAsFloat(i),6));
-            } else if( a.message.getArgType(i) == OFXOSC_TYPE_STRING ) {
-                buffer.append( "s"+a.message.getArgAsString(i) );
-            } else if( a.message.getArgType(i) == OFXOSC_TYPE_INT32 ) {
-                buffer.append("i"+ofToString(a.message.getArgAsInt(i)) );
-            }else {
-                buffer.append( "u0" );
-            }
-        }
-        buffer.append("\n");
+    // records are streamed to disk as they arrive //
+    recordingWriter.reset( new SkeletonRecordingWriter() );
+    if( !recordingWriter->open( tpath ) ) {
+        recordingWriter.reset();
     }
-    
-    ofBufferToFile( "recordings/"+uniqueFilename+".txt", buffer );
-    recordingData.clear();
 }
 
 //--------------------------------------------------------------
-void ofApp::loadPlaybackData( string afilePath ) {
-    playbackDataCached.clear();
-    
-    ofBuffer tbuffer = ofBufferFromFile( afilePath );
-    if( tbuffer.size() ) {
-        for( auto a : tbuffer.getLines() ) {
-            string lineStr = a;
-            ofStringReplace(lineStr, "\n", "");
-            vector <string> results = split(lineStr, '|');
-            
-            if( results.size() >= 5 ) {
-                SkeletonData sdata;
-                sdata.time = ofToFloat(results[0]);
-                sdata.message.setAddress(results[1]);
-                // now set the params //
-                for( int k = 2; k < results.size(); k++ ) {
-                    if( results[k] == "" ) continue;
-                    if( results[k].length() <= 1 ) continue;
-                    string vstring = results[k];
-                    vstring = vstring.substr(1, vstring.length());
-                    if( results[k][0] == 'f' ) {
-                        // float
-                        sdata.message.addFloatArg( ofToFloat(vstring));
-                    } else if( results[k][0] == 's' ) {
-                        // string //
-                        sdata.message.addStringArg( vstring );
-                    } else if( results[k][0] == 'i' ) {
-                        sdata.message.addIntArg( ofToInt(vstring) );
-                    }
-                }
-                playbackDataCached.push_back( sdata );
-            }
-        }
-    }
+void ofApp::saveRecording() {
+    // the writer thread flushes what is left and finalizes the file //
+    if( !recordingWriter ) return;
+    recordingWriter->close();
+    retiredWriters.push_back( std::move(recordingWriter) );
 }
 
 //--------------------------------------------------------------
-vector<string> ofApp::split(const string &s, char delim) {
-    stringstream ss(s);
-    string item;
-    vector<string> tokens;
-    while (getline(ss, item, delim)) {
-        tokens.push_back(item);
-    }
-    return tokens;
+void ofApp::loadPlaybackData( string afilePath ) {
+    // a load still in progress is dropped for the new one //
+    retireRecording( std::move(pendingRecording) );
+    pendingRecording.reset( new SkeletonRecording() );
+    pendingRecording->loadAsync( afilePath );
 }
 
 //--------------------------------------------------------------
@@ -334,6 +416,30 @@ void ofApp::keyPressed(int key){
     if(key == 'l') {
         gui.loadFromFile("settings.xml");
     }
+    if( key == 'p' ) {
+        FrameProfiler::get().setEnabled( !FrameProfiler::isEnabled() );
+    }
+    if( key == 't' ) {
+        FrameProfiler::get().dump();
+    }
+    if( (key == '[' || key == ']') && recordingPaths.size() ) {
+        // step through data/recordings, the recording playing now keeps going until the next one can play //
+        int numRecordings = (int)recordingPaths.size();
+        recordingIndex = (recordingIndex + (key == ']' ? 1 : -1) + numRecordings) % numRecordings;
+        loadPlaybackData( recordingPaths[recordingIndex] );
+    }
+    if( key == 'z' && playbackRecording->isComplete() ) {
+        // writes a compressed copy next to the recording for archiving //
+        SkeletonTrackCodec::compress( playbackRecording->getPath(), SkeletonTrackCodec::getCompressedPath( playbackRecording->getPath() ) );
+    }
+    if( key == 'b' ) {
+        Benchmarks::log( Benchmarks::runOscRouting( *playbackRecording ) );
+        Benchmarks::log( Benchmarks::runTrackCodec( *playbackRecording ) );
+        Benchmarks::log( Benchmarks::runFrameRelay( *playbackRecording ) );
+        Benchmarks::log( Benchmarks::runParticleBuild( particles.getCapacity() ) );
+        Benchmarks::log( Benchmarks::runSkeletonFilter( skeletonFilter ) );
+        Benchmarks::logFilterJitter( *playbackRecording, skeletonFilter );
+    }
 }
 
 //--------------------------------------------------------------
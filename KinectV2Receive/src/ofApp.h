@@ -1,36 +1,42 @@
 #pragma once
 
 #include "ofMain.h"
+#include <future>
 #include "ofxGui.h"
 #include "ofxOsc.h"
 #include "Skeleton.h"
-
-class SkeletonData {
-public:
-    ofxOscMessage message;
-    float time=0;
-};
-
-class Particle {
-public:
-    ofVec3f pos;
-    ofVec3f vel;
-    float size = 5;
-    bool bRemove = false;
-};
+#include "SkeletonRecording.h"
+#include "SkeletonRecordingWriter.h"
+#include "SkeletonTrackCodec.h"
+#include "SkeletonOscReceiver.h"
+#include "ParticleSystem.h"
+#include "ParticleRenderer.h"
+#include "SkeletonRenderer.h"
+#include "SkeletonPlayer.h"
+#include "SkeletonTable.h"
+#include "SkeletonFusion.h"
+#include "SkeletonFilter.h"
+#include "FrameProfiler.h"
+#include "SkeletonOscSender.h"
+#include "SkeletonFrameRelay.h"
 
 class ofApp : public ofBaseApp {
 public:
-    static bool shouldRemoveParticle( const Particle& p );
-    
     void setup();
     void update();
     void draw();
     
-    void parseMessage( ofxOscMessage amsg );
+    // a particle from every joint of every skeleton, as in update(), also used by ReplayBenchmark //
+    static void spawnParticles( SkeletonTable& askeletons, ParticleSystem& aparticles );
+    void processJointSample( const SkeletonJointSample& asample );
+    void updateJoint( uint64_t abodyKey, Skeleton::JointIndex ajoint, const ofVec3f& apos, Skeleton::TrackingState astate );
+    void startRecording();
     void saveRecording();
+    // starts loading afilePath in the background, it replaces the playing recording once it can be played //
     void loadPlaybackData( string afilePath );
-    vector<string> split(const string &s, char delim);
+    void updatePlaybackLoading();
+    void switchPlaybackRecording();
+    void retireRecording( unique_ptr<SkeletonRecording> arecording );
 
     void keyPressed(int key);
     void keyReleased(int key);
@@ -50,20 +56,61 @@ public:
     bool bHide;
     ofParameter<bool> bDebug;
     ofParameter<bool> bRecording;
+    ofParameter<int> maxParticles;
+    ofParameter<bool> bFilter;
+    ofParameter<float> filterMinCutoff;
+    ofParameter<float> filterBeta;
     
-    ofxOscReceiver oscRX;
+    // one receiver per sensor, each on its own thread //
+    vector< unique_ptr<SkeletonOscReceiver> > oscReceivers;
+    vector< SensorCalibration > sensors;
+    // replay the newest recording to every sensor port on loopback //
+    bool bStandInSensors = false;
+    vector< SkeletonJointSample > jointSamples;
+    vector< SkeletonJointSample > mergedSamples;
     
     string uniqueFilename="";
     float startRecordingTime=0;
     
-    vector< SkeletonData > recordingData;
+    // one writer per take, a stopped take finishes writing while the next one starts //
+    unique_ptr< SkeletonRecordingWriter > recordingWriter;
+    vector< unique_ptr<SkeletonRecordingWriter> > retiredWriters;
     bool bUseLiveOsc=false;
     
-    vector<SkeletonData> playbackData;
-    vector<SkeletonData> playbackDataCached;
-    float playbackTimeStart = 0;
+    // recordings are listed and loaded off the main thread, so startup does not depend on their size //
+    std::future< vector<string> > recordingList;
+    vector< string > recordingPaths;
+    int recordingIndex = -1;
+    unique_ptr< SkeletonRecording > playbackRecording;
+    unique_ptr< SkeletonRecording > pendingRecording;
+    // replaced recordings that are still stopping their loading thread //
+    vector< unique_ptr<SkeletonRecording> > retiredRecordings;
+    // after the recordings they read from, so their threads stop before those are freed //
+    vector< unique_ptr<SkeletonOscSender> > standInSenders;
+    SkeletonPlayer player;
+    ofParameter<float> playbackPosition;
+    ofParameter<float> playbackSpeed;
+    ofParameter<bool> bPlaybackReverse;
+    ofParameter<bool> bPlaybackLoop;
+    ofParameter<bool> bPlaybackPaused;
+    // SkeletonPlayer::Interpolation, 0 plays the samples as recorded //
+    ofParameter<int> playbackInterpolation;
+    // position written to the slider last frame, anything else is the user scrubbing //
+    float lastPlaybackPosition = 0;
     
-    map< string, shared_ptr<Skeleton> > skeletons;
+    // per sensor skeletons, keyed by sensor and body //
+    SkeletonTable skeletons;
+    // one per person, drawn and emitting particles //
+    SkeletonTable fusedSkeletons;
+    SkeletonFusion fusion;
+    // smooths the fused skeletons before they are drawn or emit particles //
+    SkeletonFilter skeletonFilter;
+    SkeletonRenderer skeletonRenderer;
+    // sends fusedSkeletons to the machines in relay.xml, off without it //
+    SkeletonFrameRelay frameRelay;
+    // stamped on every body frame assembled during this update //
+    float updateTime = 0;
     
-    vector< Particle > particles;
+    ParticleSystem particles;
+    ParticleRenderer particleRenderer;
 };